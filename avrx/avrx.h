@@ -34,13 +34,32 @@ Rest::Impl::Port> && ...);
 
 #define ALWAYS_INLINE __attribute__((always_inline))
 
+#ifdef AVRX_HOST
+#include "host/avrx_host.h"
+#define AVRX_REGISTER_WRITTEN(reg) avrx::host::RegisterWritten(reg)
+#else
+#define AVRX_REGISTER_WRITTEN(reg)
+#endif
+
 // TODO Masked register?
 
 template <typename T, typename Type> struct RegisterBase {
   static inline Type Read() { return *T::ptr(); }
-  static inline void Write(Type value) { *T::ptr() = value; }
-  template <typename... Bits> static inline void SetBits() { *T::ptr() |= (... | Bits::Mask); }
-  template <uint8_t... Bits> static inline void Write() { *T::ptr() = (... | (_BV(Bits))); }
+  static inline void Write(Type value)
+  {
+    *T::ptr() = value;
+    AVRX_REGISTER_WRITTEN(T::ptr());
+  }
+  template <typename... Bits> static inline void SetBits()
+  {
+    *T::ptr() |= (... | Bits::Mask);
+    AVRX_REGISTER_WRITTEN(T::ptr());
+  }
+  template <uint8_t... Bits> static inline void Write()
+  {
+    *T::ptr() = (... | (_BV(Bits)));
+    AVRX_REGISTER_WRITTEN(T::ptr());
+  }
 };
 
 #define IOREGISTER8(reg)                                               \
@@ -97,8 +116,16 @@ template <typename Register, uint8_t bit> struct RegisterBit {
   using Type = typename Register::Type;
   static constexpr Type Mask = _BV(bit);
 
-  static inline void reset() ALWAYS_INLINE { *Register::ptr() &= ~Mask; }
-  static inline void set() ALWAYS_INLINE { *Register::ptr() |= Mask; }
+  static inline void reset() ALWAYS_INLINE
+  {
+    *Register::ptr() &= ~Mask;
+    AVRX_REGISTER_WRITTEN(Register::ptr());
+  }
+  static inline void set() ALWAYS_INLINE
+  {
+    *Register::ptr() |= Mask;
+    AVRX_REGISTER_WRITTEN(Register::ptr());
+  }
   static inline void set(bool value)
   {
     if (value)
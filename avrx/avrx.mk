@@ -115,6 +115,11 @@ size: $(TARGET_SIZE)
 symbols: $(TARGET_SYM)
 	$(AT)cat $(TARGET_SYM)
 
+# RAM (.data, .bss, .noinit) symbols by size
+.PHONY: ram
+ram: $(TARGET_ELF)
+	$(AT)$(NM) --size-sort -CrS -t d $< | grep -i ' [bdvu] '
+
 .PHONY: disassemble
 disassemble: $(TARGET_DIS)
 
@@ -134,6 +139,7 @@ clean:
 	$(RM) $(BUILD_DIR)/*.d $(BUILD_DIR)/*.o
 	$(RM) $(TARGET_ELF)
 	$(RM) $(TARGET_DIS) $(TARGET_MAP) $(TARGET_SIZE) $(TARGET_SYM)
+	$(RM) $(BENCH_TARGET) $(MICROBENCH_ELF)
 
 CPPCHECK_FLAGS ?= --enable=all -inconclusives --inline-suppr
 CPPCHECK_FLAGS += --platform=avr8
@@ -146,6 +152,57 @@ CPPCHECK_FLAGS += $(addprefix -D,$(CPPCHECK_DEFINES))
 check:
 	$(AT)cppcheck $(CPPCHECK_FLAGS) $(CPPCHECK_EXTRA) $(CPPCHECK_SRC)
 
+###
+## Benchmarks
+#
+# Runs $(TARGET_ELF) in simavr using a host-side harness that provides the peripheral models.
+# The harness is project specific (BENCH_SRC, BENCH_CPPFLAGS) and needs simavr + libelf.
+HOST_CXX      ?= g++
+SIMAVR_CFLAGS ?= $(shell pkg-config --cflags simavr 2>/dev/null)
+SIMAVR_LIBS   ?= $(shell pkg-config --libs simavr 2>/dev/null || echo -lsimavr -lelf)
+BENCH_FLAGS   ?= -std=c++17 -O2 -Wall -Wextra
+BENCH_TARGET   = $(BUILD_DIR)/$(PROJECT)_bench
+BENCH_ARGS    ?=
+
+.PHONY: bench
+ifneq (,$(BENCH_SRC))
+bench: $(BENCH_TARGET) $(TARGET_ELF)
+	$(AT)$(BENCH_TARGET) -m $(TARGET_MCU) -f $(F_CPU) $(BENCH_ARGS) $(TARGET_ELF)
+else
+bench:
+	$(error No BENCH_SRC defined for $(PROJECT))
+endif
+
+$(BENCH_TARGET): $(BENCH_SRC) | $(BUILD_DIR)
+	$(ECHO) "Building $@..."
+	$(AT)$(HOST_CXX) $(BENCH_FLAGS) $(BENCH_CPPFLAGS) $(SIMAVR_CFLAGS) $^ $(SIMAVR_LIBS) -o $@
+
+###
+## Microbenchmarks
+#
+# Standalone ELF built from MICROBENCH_SRC (which provides main) with the project flags, and run in
+# simavr. The benchmarks report their cycle counts via the UART.
+SIMAVR_RUN     ?= run_avr
+MICROBENCH_ELF  = $(BUILD_DIR)/$(PROJECT)_microbench.elf
+MICROBENCH_OBJS = $(patsubst %,$(BUILD_DIR)/%,$(notdir $(MICROBENCH_SRC:.cc=.o)))
+VPATH += $(sort $(dir $(MICROBENCH_SRC)))
+comma := ,
+
+.PHONY: microbench
+ifneq (,$(MICROBENCH_SRC))
+microbench: $(MICROBENCH_ELF)
+	$(AT)$(SIMAVR_RUN) -m $(TARGET_MCU) -f $(F_CPU) $<
+else
+microbench:
+	$(error No MICROBENCH_SRC defined for $(PROJECT))
+endif
+
+$(MICROBENCH_ELF): $(MICROBENCH_OBJS)
+	$(ECHO) "Linking $@..."
+	$(AT)$(CC) $(filter-out -Wl$(comma)-Map=%,$(LDFLAGS)) $^ -o $@
+
+$(MICROBENCH_OBJS) : | $(BUILD_DIR)
+
 ###
 ## Build rules
 #
@@ -174,4 +231,4 @@ $(TARGET_SYM): $(TARGET_ELF)
 $(OBJS) : | $(BUILD_DIR)
 
 # Automatic dependency generation
--include $(DEPS)
+-include $(DEPS) $(MICROBENCH_OBJS:.o=.d)
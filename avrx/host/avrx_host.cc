@@ -0,0 +1,110 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "avrx_host.h"
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define AVRX_HOST_DEFINE_REGISTER8(reg) volatile uint8_t reg;
+#define AVRX_HOST_DEFINE_REGISTER16(reg) volatile uint16_t reg;
+AVRX_HOST_REGISTERS8(AVRX_HOST_DEFINE_REGISTER8)
+AVRX_HOST_REGISTERS16(AVRX_HOST_DEFINE_REGISTER16)
+
+namespace avrx {
+namespace host {
+
+static RegisterWriteHook register_write_hook = nullptr;
+
+void SetRegisterWriteHook(RegisterWriteHook hook)
+{
+  register_write_hook = hook;
+}
+
+void RegisterWritten(volatile void *reg)
+{
+  if (register_write_hook) register_write_hook(reg);
+}
+
+void ResetRegisters()
+{
+#define AVRX_HOST_RESET_REGISTER(reg) reg = 0;
+  AVRX_HOST_REGISTERS8(AVRX_HOST_RESET_REGISTER)
+  AVRX_HOST_REGISTERS16(AVRX_HOST_RESET_REGISTER)
+#undef AVRX_HOST_RESET_REGISTER
+}
+
+}  // namespace host
+}  // namespace avrx
+
+// %S (PROGMEM string) => %s, everything else is passed through unchanged
+static const char *translate_format(char *dst, size_t size, const char *fmt)
+{
+  char *end = dst + size - 1;
+  char *d = dst;
+  while (*fmt && d < end) {
+    char c = *fmt++;
+    *d++ = c;
+    if ('%' != c) continue;
+    while (*fmt && d < end && strchr("-+ #0123456789.*lhz", *fmt)) *d++ = *fmt++;
+    if (*fmt && d < end) {
+      c = *fmt++;
+      *d++ = 'S' == c ? 's' : c;
+    }
+  }
+  *d = '\0';
+  return dst;
+}
+
+int vsnprintf_P(char *buffer, size_t size, const char *fmt, va_list args)
+{
+  char host_fmt[256];
+  return vsnprintf(buffer, size, translate_format(host_fmt, sizeof(host_fmt), fmt), args);
+}
+
+int sprintf_P(char *buffer, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  // There's no size, but all the callers have buffers that are (supposed to be) large enough
+  auto result = vsnprintf_P(buffer, 256, fmt, args);
+  va_end(args);
+  return result;
+}
+
+int snprintf_P(char *buffer, size_t size, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  auto result = vsnprintf_P(buffer, size, fmt, args);
+  va_end(args);
+  return result;
+}
+
+int printf_P(const char *fmt, ...)
+{
+  char host_fmt[256];
+  va_list args;
+  va_start(args, fmt);
+  auto result = vprintf(translate_format(host_fmt, sizeof(host_fmt), fmt), args);
+  va_end(args);
+  return result;
+}
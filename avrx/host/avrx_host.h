@@ -0,0 +1,48 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef AVRX_HOST_H_
+#define AVRX_HOST_H_
+
+#include <stdint.h>
+
+// Host backend for the avrx register templates.
+//
+// Writes that go through RegisterBase/RegisterBit (and so all the GPIO wrappers) are reported to
+// an optional hook after the register variable has been updated. This allows tools to model the
+// peripherals hanging off the pins (e.g. latch display data on a falling strobe) without any
+// changes to the drivers. Direct assignments (SPDR = x) are not seen.
+
+namespace avrx {
+namespace host {
+
+using RegisterWriteHook = void (*)(volatile void *reg);
+
+void SetRegisterWriteHook(RegisterWriteHook hook);
+void RegisterWritten(volatile void *reg);
+
+// Reset all I/O registers to zero
+void ResetRegisters();
+
+}  // namespace host
+}  // namespace avrx
+
+#endif  // AVRX_HOST_H_
@@ -0,0 +1,42 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef AVRX_HOST_AVR_EEPROM_H_
+#define AVRX_HOST_AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Host stand-in for avr-libc's <avr/eeprom.h>. EEMEM variables are just regular (zeroed, not
+// erased) RAM, so contents don't survive between runs.
+
+#define EEMEM
+
+inline uint8_t eeprom_read_byte(const uint8_t *addr) { return *addr; }
+inline void eeprom_update_byte(uint8_t *addr, uint8_t value) { *addr = value; }
+inline void eeprom_write_byte(uint8_t *addr, uint8_t value) { *addr = value; }
+
+inline void eeprom_read_block(void *dst, const void *src, size_t n) { memcpy(dst, src, n); }
+inline void eeprom_update_block(const void *src, void *dst, size_t n) { memcpy(dst, src, n); }
+inline void eeprom_write_block(const void *src, void *dst, size_t n) { memcpy(dst, src, n); }
+
+#endif  // AVRX_HOST_AVR_EEPROM_H_
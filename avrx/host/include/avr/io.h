@@ -0,0 +1,107 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef AVRX_HOST_AVR_IO_H_
+#define AVRX_HOST_AVR_IO_H_
+
+#ifndef AVRX_HOST
+#error "avrx/host/include is only for AVRX_HOST builds"
+#endif
+
+#include <stdint.h>
+
+// Host stand-in for avr-libc's <avr/io.h> (ATmega328P subset).
+//
+// The I/O registers are plain variables (defined in avrx_host.cc) so the IOREGISTER8 templates
+// and the drivers can take their address as usual. Nothing happens on a write unless a tool has
+// installed a hook (\sa avrx/host/avrx_host.h) and the write went through the register templates.
+
+#define _BV(bit) (1 << (bit))
+
+#define AVRX_HOST_REGISTERS8(X)                                                                \
+  X(PINB) X(DDRB) X(PORTB) X(PINC) X(DDRC) X(PORTC) X(PIND) X(DDRD) X(PORTD) X(TIFR0) X(TIFR1) \
+  X(TIFR2) X(PCIFR) X(EIFR) X(EIMSK) X(GPIOR0) X(EECR) X(EEDR) X(GPIOR1) X(GPIOR2) X(TCCR0A)  \
+  X(TCCR0B) X(TCNT0) X(OCR0A) X(OCR0B) X(SPCR) X(SPSR) X(SPDR) X(ACSR) X(SMCR) X(MCUSR)       \
+  X(MCUCR) X(SPMCSR) X(WDTCSR) X(CLKPR) X(PRR) X(OSCCAL) X(PCICR) X(EICRA) X(PCMSK0)         \
+  X(PCMSK1) X(PCMSK2) X(TIMSK0) X(TIMSK1) X(TIMSK2) X(ADCSRA) X(ADCSRB) X(ADMUX) X(DIDR0)     \
+  X(DIDR1) X(TCCR1A) X(TCCR1B) X(TCCR1C) X(TCCR2A) X(TCCR2B) X(TCNT2) X(OCR2A) X(OCR2B)      \
+  X(ASSR) X(TWBR) X(TWSR) X(TWAR) X(TWDR) X(TWCR) X(TWAMR) X(UCSR0A) X(UCSR0B) X(UCSR0C)      \
+  X(UBRR0L) X(UBRR0H) X(UDR0) X(SREG)
+
+#define AVRX_HOST_REGISTERS16(X) X(EEAR) X(ADC) X(ICR1) X(TCNT1) X(OCR1A) X(OCR1B) X(UBRR0) X(SP)
+
+#define AVRX_HOST_DECLARE_REGISTER8(reg) extern volatile uint8_t reg;
+#define AVRX_HOST_DECLARE_REGISTER16(reg) extern volatile uint16_t reg;
+AVRX_HOST_REGISTERS8(AVRX_HOST_DECLARE_REGISTER8)
+AVRX_HOST_REGISTERS16(AVRX_HOST_DECLARE_REGISTER16)
+
+// Some code checks for the existence of a port
+#define PORTB PORTB
+#define PORTC PORTC
+#define PORTD PORTD
+
+#define ADCW ADC
+
+#define RAMSTART 0x100
+#define RAMEND 0x8ff
+#define E2END 0x3ff
+#define FLASHEND 0x7fff
+
+// Bit positions
+enum { PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7 };
+enum { PC0, PC1, PC2, PC3, PC4, PC5, PC6 };
+enum { PD0, PD1, PD2, PD3, PD4, PD5, PD6, PD7 };
+
+// SREG
+enum { SREG_C = 0, SREG_Z = 1, SREG_N = 2, SREG_V = 3, SREG_S = 4, SREG_H = 5, SREG_T = 6, SREG_I = 7 };
+// MCUSR
+enum { PORF = 0, EXTRF = 1, BORF = 2, WDRF = 3 };
+// WDTCSR
+enum { WDP0 = 0, WDP1 = 1, WDP2 = 2, WDE = 3, WDCE = 4, WDP3 = 5, WDIE = 6, WDIF = 7 };
+// Timer0
+enum { WGM00 = 0, WGM01 = 1, COM0B0 = 4, COM0B1 = 5, COM0A0 = 6, COM0A1 = 7 };
+enum { CS00 = 0, CS01 = 1, CS02 = 2, WGM02 = 3, FOC0B = 6, FOC0A = 7 };
+enum { TOIE0 = 0, OCIE0A = 1, OCIE0B = 2 };
+enum { TOV0 = 0, OCF0A = 1, OCF0B = 2 };
+// Timer1
+enum { WGM10 = 0, WGM11 = 1, COM1B0 = 4, COM1B1 = 5, COM1A0 = 6, COM1A1 = 7 };
+enum { CS10 = 0, CS11 = 1, CS12 = 2, WGM12 = 3, WGM13 = 4, ICES1 = 6, ICNC1 = 7 };
+enum { TOIE1 = 0, OCIE1A = 1, OCIE1B = 2, ICIE1 = 5 };
+enum { TOV1 = 0, OCF1A = 1, OCF1B = 2, ICF1 = 5 };
+// SPI
+enum { SPR0 = 0, SPR1 = 1, CPHA = 2, CPOL = 3, MSTR = 4, DORD = 5, SPE = 6, SPIE = 7 };
+enum { SPI2X = 0, WCOL = 6, SPIF = 7 };
+// TWI
+enum { TWIE = 0, TWEN = 2, TWWC = 3, TWSTO = 4, TWSTA = 5, TWEA = 6, TWINT = 7 };
+enum { TWPS0 = 0, TWPS1 = 1 };
+// USART
+enum { MPCM0 = 0, U2X0 = 1, UPE0 = 2, DOR0 = 3, FE0 = 4, UDRE0 = 5, TXC0 = 6, RXC0 = 7 };
+enum { TXB80 = 0, RXB80 = 1, UCSZ02 = 2, TXEN0 = 3, RXEN0 = 4, UDRIE0 = 5, TXCIE0 = 6, RXCIE0 = 7 };
+enum { UCPOL0 = 0, UCSZ00 = 1, UCSZ01 = 2, USBS0 = 3, UPM00 = 4, UPM01 = 5, UMSEL00 = 6, UMSEL01 = 7 };
+// ADC
+enum { ADPS0 = 0, ADPS1 = 1, ADPS2 = 2, ADIE = 3, ADIF = 4, ADATE = 5, ADSC = 6, ADEN = 7 };
+enum { MUX0 = 0, MUX1 = 1, MUX2 = 2, MUX3 = 3, ADLAR = 5, REFS0 = 6, REFS1 = 7 };
+// EEPROM
+enum { EERE = 0, EEPE = 1, EEMPE = 2, EERIE = 3 };
+// SMCR
+enum { SE = 0, SM0 = 1, SM1 = 2, SM2 = 3 };
+
+#endif  // AVRX_HOST_AVR_IO_H_
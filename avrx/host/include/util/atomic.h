@@ -0,0 +1,36 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef AVRX_HOST_UTIL_ATOMIC_H_
+#define AVRX_HOST_UTIL_ATOMIC_H_
+
+// Host stand-in for avr-libc's <util/atomic.h>. Host builds are single threaded and there are
+// no interrupts, so the blocks just execute once.
+
+#define ATOMIC_FORCEON
+#define ATOMIC_RESTORESTATE
+#define NONATOMIC_FORCEOFF
+#define NONATOMIC_RESTORESTATE
+
+#define ATOMIC_BLOCK(type) for (bool __todo = true; __todo; __todo = false)
+#define NONATOMIC_BLOCK(type) for (bool __todo = true; __todo; __todo = false)
+
+#endif  // AVRX_HOST_UTIL_ATOMIC_H_
@@ -22,7 +22,40 @@
 #ifndef AVRX_PROGMEM_H_
 #define AVRX_PROGMEM_H_
 
+#ifdef AVRX_HOST
+// Host builds (unit tests, benchmarks, sanitizers) have a flat address space so the pgm_read_*
+// family becomes plain loads. The printf-style functions need a real implementation since the
+// avr-libc %S (PROGMEM string) has to be translated; see host/avrx_host.cc.
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+
+int vsnprintf_P(char *buffer, size_t size, const char *fmt, va_list args);
+int sprintf_P(char *buffer, const char *fmt, ...);
+int snprintf_P(char *buffer, size_t size, const char *fmt, ...);
+int printf_P(const char *fmt, ...);
+#else
 #include <avr/pgmspace.h>
+#endif
 
 // TODO string wrapper?
 // TODO __flash is nice, but not available in C++
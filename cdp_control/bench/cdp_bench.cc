@@ -0,0 +1,326 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Cycle benchmark for the complete cdp_control firmware running in simavr, with models of the
+// board peripherals attached (\sa peripherals.h). Each scenario boots the unmodified ELF, runs it
+// until the state of interest is reached and then measures for a fixed window:
+// - cycles per SYSTICK_ISR (from the vector to the return)
+// - main loop iteration time (between executions of the wdr at the top of the loop)
+// - VFD bytes, SRC4392 I2C transactions and MCP23S17 SPI transactions per second
+//
+// Usage: cdp_bench [-m mcu] [-f frequency] [-t seconds] [-v] firmware.elf [scenario...]
+//
+#include <simavr/avr_adc.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_irq.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drivers/relays.h"
+#include "host/dsa_peer.h"
+#include "peripherals.h"
+
+namespace bench {
+
+// TIMER0_COMPA_vect is vector 14 on the ATmega328P, two words per vector
+static constexpr uint32_t kSysTickVector = 14 * 4;
+static constexpr uint16_t kOpcodeWDR = 0x95a8;
+static constexpr uint32_t kLidClosedMillivolts = 4500;
+
+struct Options {
+  const char *mcu = "atmega328p";
+  uint32_t frequency = 20000000;
+  uint32_t seconds = 5;
+  bool verbose = false;
+};
+static Options options;
+
+struct Metrics {
+  uint64_t start_cycle = 0;
+
+  uint32_t isr_count = 0;
+  uint64_t isr_cycles = 0;
+  uint32_t isr_max = 0;
+
+  uint32_t loop_count = 0;
+  uint64_t loop_cycles = 0;
+  uint32_t loop_max = 0;
+
+  uint32_t vfd_bytes = 0;
+  uint32_t i2c_transactions = 0;
+  uint32_t spi_transactions = 0;
+  uint32_t dsa_messages = 0;
+};
+
+class Board {
+public:
+  ~Board()
+  {
+    if (avr_) avr_terminate(avr_);
+  }
+
+  bool Init(const char *firmware_path);
+
+  // Run until condition is true (or timeout). A null condition runs for the full time.
+  bool Run(uint32_t millis, bool (*condition)(Board &) = nullptr);
+
+  void StartMeasurement();
+  void Report(const char *scenario, bool result) const;
+
+  void SendConsole(const char *line);
+
+  uint32_t millis() const { return avr_->cycle * 1024 / options.frequency; }
+
+private:
+  avr_t *avr_ = nullptr;
+  Mcp23s17 mcp_;
+  Vfd vfd_;
+  Src4392 src_;
+  DsaLink dsa_;
+
+  bool in_isr_ = false;
+  uint64_t isr_start_ = 0;
+  uint32_t isr_return_pc_ = 0;
+  uint16_t isr_sp_ = 0;
+  uint64_t loop_start_ = 0;
+  uint32_t last_millis_ = ~0U;
+
+  Metrics metrics_;
+  Metrics baseline_;
+
+  uint16_t sp() const { return avr_->data[kSPL] | (avr_->data[kSPH] << 8); }
+  uint16_t opcode(uint32_t pc) const { return avr_->flash[pc] | (avr_->flash[pc + 1] << 8); }
+
+  static void OnUartOutput(struct avr_irq_t *irq, uint32_t value, void *param);
+};
+
+bool Board::Init(const char *firmware_path)
+{
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(firmware_path, &firmware)) {
+    fprintf(stderr, "Failed to read %s\n", firmware_path);
+    return false;
+  }
+  if (!firmware.mmcu[0]) strncpy(firmware.mmcu, options.mcu, sizeof(firmware.mmcu) - 1);
+  firmware.frequency = options.frequency;
+
+  avr_ = avr_make_mcu_by_name(firmware.mmcu);
+  if (!avr_) {
+    fprintf(stderr, "Unknown MCU %s\n", firmware.mmcu);
+    return false;
+  }
+  avr_init(avr_);
+  avr_load_firmware(avr_, &firmware);
+  avr_->frequency = options.frequency;
+  avr_->vcc = avr_->avcc = avr_->aref = 5000;
+
+  mcp_.Attach(avr_);
+  vfd_.Attach(avr_);
+  src_.Attach(avr_);
+  dsa_.Attach(avr_);
+
+  // RC5 idle, lid closed
+  avr_raise_irq(avr_io_getirq(avr_, AVR_IOCTL_IOPORT_GETIRQ('D'), 2), 1);
+  avr_raise_irq(avr_io_getirq(avr_, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + 7), kLidClosedMillivolts);
+
+  uint32_t flags = 0;
+  avr_ioctl(avr_, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr_, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+  avr_irq_register_notify(avr_io_getirq(avr_, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                          OnUartOutput, this);
+
+  cdp::host::DsaPeer::Reset({});
+  return true;
+}
+
+/*static*/ void Board::OnUartOutput(struct avr_irq_t *, uint32_t value, void *)
+{
+  if (options.verbose) putchar(value);
+}
+
+void Board::SendConsole(const char *line)
+{
+  auto input = avr_io_getirq(avr_, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+  while (*line) avr_raise_irq(input, *line++);
+  avr_raise_irq(input, '\n');  // SerialConsole::Poll dispatches on \n
+}
+
+bool Board::Run(uint32_t millis, bool (*condition)(Board &))
+{
+  auto end = avr_->cycle + (uint64_t)millis * options.frequency / 1024;
+  while (avr_->cycle < end) {
+    if (kOpcodeWDR == opcode(avr_->pc)) {
+      if (loop_start_) {
+        uint32_t cycles = avr_->cycle - loop_start_;
+        ++metrics_.loop_count;
+        metrics_.loop_cycles += cycles;
+        if (cycles > metrics_.loop_max) metrics_.loop_max = cycles;
+      }
+      loop_start_ = avr_->cycle;
+    }
+
+    auto state = avr_run(avr_);
+    if (cpu_Done == state || cpu_Crashed == state) {
+      fprintf(stderr, "CPU stopped at %04x (%d)\n", avr_->pc, state);
+      return false;
+    }
+
+    if (!in_isr_ && kSysTickVector == avr_->pc) {
+      // The return address has just been pushed (high byte last)
+      in_isr_ = true;
+      isr_start_ = avr_->cycle;
+      isr_sp_ = sp();
+      isr_return_pc_ = ((avr_->data[isr_sp_ + 1] << 8) | avr_->data[isr_sp_ + 2]) * 2;
+    } else if (in_isr_ && isr_return_pc_ == avr_->pc && sp() == isr_sp_ + 2) {
+      in_isr_ = false;
+      uint32_t cycles = avr_->cycle - isr_start_;
+      ++metrics_.isr_count;
+      metrics_.isr_cycles += cycles;
+      if (cycles > metrics_.isr_max) metrics_.isr_max = cycles;
+    }
+
+    vfd_.Poll();
+    mcp_.Poll();
+
+    auto now = this->millis();
+    dsa_.Poll(now);
+    if (now != last_millis_) {
+      last_millis_ = now;
+      using cdp::Relays;
+      Relays::set<Relays::AUX_AC>(mcp_.outputs & Relays::AUX_AC);
+      Relays::set<Relays::AUX_9V>(mcp_.outputs & Relays::AUX_9V);
+      cdp::host::DsaPeer::Tick(now);
+      if (condition && condition(*this)) return true;
+    }
+  }
+  return !condition;
+}
+
+void Board::StartMeasurement()
+{
+  metrics_ = {};
+  metrics_.start_cycle = avr_->cycle;
+  baseline_.vfd_bytes = vfd_.bytes();
+  baseline_.i2c_transactions = src_.transactions;
+  baseline_.spi_transactions = mcp_.transactions;
+  baseline_.dsa_messages = dsa_.messages_rx + dsa_.messages_tx;
+}
+
+void Board::Report(const char *scenario, bool result) const
+{
+  double seconds = (double)(avr_->cycle - metrics_.start_cycle) / options.frequency;
+  double us_per_cycle = 1e6 / options.frequency;
+  auto per_second = [seconds](uint32_t count) { return seconds > 0 ? count / seconds : 0; };
+  auto average = [](uint64_t total, uint32_t count) { return count ? (double)total / count : 0; };
+
+  printf("%-8s %-4s %7.1f %6u %5.1f%% %8.1f %8.1f %8.0f %8.1f %8.1f %8.1f\n", scenario,
+         result ? "OK" : "FAIL", average(metrics_.isr_cycles, metrics_.isr_count),
+         metrics_.isr_max, 100.0 * metrics_.isr_cycles / (seconds * options.frequency),
+         average(metrics_.loop_cycles, metrics_.loop_count) * us_per_cycle,
+         metrics_.loop_max * us_per_cycle, per_second(vfd_.bytes() - baseline_.vfd_bytes),
+         per_second(src_.transactions - baseline_.i2c_transactions),
+         per_second(mcp_.transactions - baseline_.spi_transactions),
+         per_second(dsa_.messages_rx + dsa_.messages_tx - baseline_.dsa_messages));
+}
+
+// Scenarios
+
+static constexpr uint32_t kBootMillis = 3 * 1024;  // Includes the splash screen
+static constexpr uint32_t kPlayTimeoutMillis = 15 * 1024;
+
+static bool Idle(Board &board)
+{
+  if (!board.Run(kBootMillis)) return false;
+  board.StartMeasurement();
+  return board.Run(options.seconds * 1024);
+}
+
+static bool Play(Board &board)
+{
+  if (!board.Run(kBootMillis)) return false;
+  board.SendConsole("cd power");
+  if (!board.Run(kPlayTimeoutMillis, [](Board &) { return cdp::host::DsaPeer::playing(); }))
+    return false;
+  board.StartMeasurement();
+  return board.Run(options.seconds * 1024) && cdp::host::DsaPeer::playing();
+}
+
+struct Scenario {
+  const char *name;
+  bool (*fn)(Board &);
+};
+
+static const Scenario kScenarios[] = {
+    {"idle", Idle},
+    {"play", Play},
+};
+
+}  // namespace bench
+
+using namespace bench;
+
+int main(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "m:f:t:v")) != -1) {
+    switch (opt) {
+      case 'm': options.mcu = optarg; break;
+      case 'f': options.frequency = strtoul(optarg, nullptr, 0); break;
+      case 't': options.seconds = strtoul(optarg, nullptr, 0); break;
+      case 'v': options.verbose = true; break;
+      default: optind = argc + 1; break;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "Usage: %s [-m mcu] [-f hz] [-t seconds] [-v] firmware.elf [scenario...]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char *firmware_path = argv[optind++];
+
+  printf("%-8s %-4s %7s %6s %6s %8s %8s %8s %8s %8s %8s\n", "SCENARIO", "", "ISR_AVG", "ISR_MX",
+         "ISR%", "LOOP_US", "LOOP_MX", "VFD_B/S", "I2C/S", "SPI/S", "DSA/S");
+
+  unsigned failed = 0;
+  for (const auto &scenario : kScenarios) {
+    if (optind < argc) {
+      bool selected = false;
+      for (int i = optind; i < argc; ++i) selected |= !strcmp(argv[i], scenario.name);
+      if (!selected) continue;
+    }
+
+    Board board;
+    if (!board.Init(firmware_path)) return EXIT_FAILURE;
+    bool result = scenario.fn(board);
+    board.Report(scenario.name, result);
+    if (!result) ++failed;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "micro_bench.h"
+
+#include <stdio.h>
+
+#ifdef AVRX_HOST
+#include <time.h>
+#else
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#define BAUD SERIAL_BAUD
+#include <util/setbaud.h>
+#endif
+
+namespace bench {
+
+/*static*/ MicroBench::Ticks MicroBench::overhead_ = 0;
+
+#ifdef AVRX_HOST
+static constexpr const char *kUnit = "NS/OP";
+
+/*static*/ MicroBench::Ticks MicroBench::now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (Ticks)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void Print(const char *str)
+{
+  fputs(str, stdout);
+}
+
+#else
+static constexpr const char *kUnit = "CYCLES/OP";
+
+static volatile uint16_t timer1_overflows = 0;
+
+ISR(TIMER1_OVF_vect)
+{
+  ++timer1_overflows;
+}
+
+/*static*/ MicroBench::Ticks MicroBench::now()
+{
+  uint16_t ticks, overflows;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ticks = TCNT1;
+    overflows = timer1_overflows;
+    // The counter may have wrapped after the interrupts were disabled
+    if ((TIFR1 & _BV(TOV1)) && ticks < 0x8000) ++overflows;
+  }
+  return ((Ticks)overflows << 16) | ticks;
+}
+
+// Polled, simavr prints the UART output line by line
+static void Print(const char *str)
+{
+  while (*str) {
+    while (!(UCSR0A & _BV(UDRE0))) {}
+    UDR0 = *str++;
+  }
+}
+#endif
+
+/*static*/ void MicroBench::Init()
+{
+#ifndef AVRX_HOST
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);  // F_CPU
+  TIMSK1 = _BV(TOIE1);
+  sei();
+
+#if USE_2X
+  UCSR0A |= _BV(U2X0);
+#endif
+  UBRR0H = UBRRH_VALUE;
+  UBRR0L = UBRRL_VALUE;
+  UCSR0B = _BV(TXEN0);
+#endif
+
+  overhead_ = 0;
+  Ticks best = ~(Ticks)0;
+  for (uint8_t batch = 0; batch < kBatches; ++batch) {
+    auto start = now();
+    for (uint16_t i = 0; i < kOps; ++i) DoNotOptimize(i);
+    Ticks elapsed = now() - start;
+    if (elapsed < best) best = elapsed;
+  }
+  overhead_ = best;
+}
+
+/*static*/ void MicroBench::Header()
+{
+  char line[64];
+  snprintf_P(line, sizeof(line), PSTR("%-24s %5s %10s\n"), "BENCHMARK", "OPS", kUnit);
+  Print(line);
+}
+
+/*static*/ void MicroBench::Report(const char *name, uint32_t per_op_x10)
+{
+  char line[64];
+  snprintf_P(line, sizeof(line), PSTR("%-24S %5u %8lu.%lu\n"), name, kOps,
+             (unsigned long)(per_op_x10 / 10), (unsigned long)(per_op_x10 % 10));
+  Print(line);
+}
+
+/*static*/ void MicroBench::Done()
+{
+#ifndef AVRX_HOST
+  while (!(UCSR0A & _BV(TXC0))) {}
+  // simavr stops when sleeping with interrupts disabled
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+#endif
+}
+
+}  // namespace bench
+
+int main()
+{
+  using bench::MicroBench;
+  MicroBench::Init();
+  MicroBench::Header();
+  bench::UtilBenchmarks();
+  bench::TraceBenchmarks();
+  MicroBench::Done();
+  return 0;
+}
@@ -0,0 +1,100 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef BENCH_MICRO_BENCH_H_
+#define BENCH_MICRO_BENCH_H_
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+// Minimal microbenchmark harness that builds for the AVR (run in simavr or on the board, see
+// `make microbench`) and for the host (`make -C host microbench`).
+//
+// On the AVR the time base is Timer1 running at F_CPU, extended to 32 bits by counting overflows,
+// so results are in cycles. The overflow ISR is the only interrupt (~40 cycles per 65536) and the
+// code is deterministic, so a single batch is exact. On the host it's nanoseconds from
+// CLOCK_MONOTONIC and the best of several batches is reported.
+//
+// Each benchmark function gets the number of operations to run; the harness subtracts the cost of
+// an empty loop with the same count.
+
+namespace bench {
+
+class MicroBench {
+public:
+#ifdef AVRX_HOST
+  using Ticks = uint64_t;
+  static constexpr uint16_t kOps = 10000;
+  static constexpr uint8_t kBatches = 16;
+#else
+  using Ticks = uint32_t;
+  static constexpr uint16_t kOps = 32;
+  static constexpr uint8_t kBatches = 1;
+#endif
+
+  static void Init();
+
+  // Returns ticks per op * 10, minus the baseline (also ticks per op * 10)
+  template <typename F> static uint32_t Run(const char *name, F &&fn, uint32_t baseline = 0)
+  {
+    auto per_op = Measure(fn);
+    per_op = per_op > baseline ? per_op - baseline : 0;
+    Report(name, per_op);
+    return per_op;
+  }
+
+  // Same without reporting
+  template <typename F> static uint32_t Measure(F &&fn)
+  {
+    Ticks best = ~(Ticks)0;
+    for (uint8_t batch = 0; batch < kBatches; ++batch) {
+      auto start = now();
+      fn(kOps);
+      Ticks elapsed = now() - start;
+      if (elapsed < best) best = elapsed;
+    }
+    best = best > overhead_ ? best - overhead_ : 0;
+    return (uint32_t)best * 10 / kOps;
+  }
+
+  static void Header();
+  static void Report(const char *name, uint32_t per_op_x10);  // name is PROGMEM
+  static void Done();
+
+  // Keep the compiler from discarding a value or hoisting it out of the loop
+  template <typename T> static inline void DoNotOptimize(const T &value)
+  {
+    asm volatile("" : : "r"(value) : "memory");
+  }
+
+private:
+  static Ticks overhead_;
+
+  static Ticks now();
+};
+
+// Benchmark groups
+void UtilBenchmarks();
+void TraceBenchmarks();
+
+}  // namespace bench
+
+#endif  // BENCH_MICRO_BENCH_H_
@@ -0,0 +1,96 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <avr/pgmspace.h>
+
+#include "micro_bench.h"
+#include "serial_protocol.h"
+#include "serial_trace.h"
+#include "util/cobs.h"
+
+// Deferred traces (ENABLE_DEFERRED_TRACE) with typical arguments. The trace_log_* rows are the cost
+// at the call site, the trace_flush row adds the framing that's done later from the main loop.
+
+namespace cdp {
+
+// Stands in for the firmware version: the same crc + COBS encode, minus the copy to the tx ring.
+static uint8_t tx_frame[util::Cobs::EncodedLength(SerialProtocol::kMaxFrameLength) + 2];
+
+/*static*/ void SerialProtocol::Send(uint8_t *frame, uint8_t length)
+{
+  frame[length] = util::Crc8(frame, length);
+  auto encoded_length = util::Cobs::Encode(frame, length + 1, tx_frame + 1);
+  tx_frame[0] = tx_frame[encoded_length + 1] = 0;
+}
+
+}  // namespace cdp
+
+namespace bench {
+
+using cdp::SerialTrace;
+
+// Only the address matters
+static const char trace_id[] PROGMEM = "";
+static char trace_str[] = "abcdefgh";
+
+void TraceBenchmarks()
+{
+  // The ring is discarded after each op so Log never flushes, which is measured separately
+  auto discard = MicroBench::Measure([](uint16_t n) {
+    while (n--) SerialTrace::Discard();
+  });
+  MicroBench::Run(
+      PSTR("trace_log_u16x2"),
+      [](uint16_t n) {
+        while (n--) {
+          SerialTrace::Log(trace_id, n, (uint8_t)n);
+          SerialTrace::Discard();
+        }
+      },
+      discard);
+  MicroBench::Run(
+      PSTR("trace_log_u32"),
+      [](uint16_t n) {
+        while (n--) {
+          SerialTrace::Log(trace_id, (uint32_t)n << 8);
+          SerialTrace::Discard();
+        }
+      },
+      discard);
+  MicroBench::Run(
+      PSTR("trace_log_str"),
+      [](uint16_t n) {
+        while (n--) {
+          SerialTrace::Log(trace_id, trace_str);
+          SerialTrace::Discard();
+        }
+      },
+      discard);
+  MicroBench::Run(PSTR("trace_flush_u16x2"), [](uint16_t n) {
+    while (n--) {
+      SerialTrace::Log(trace_id, n, (uint8_t)n);
+      SerialTrace::Flush();
+      MicroBench::DoNotOptimize(cdp::tx_frame[1]);
+    }
+  });
+}
+
+}  // namespace bench
@@ -0,0 +1,152 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "micro_bench.h"
+#include "ui/ui_event.h"
+#include "util/command_tokenizer.h"
+#include "util/encoder.h"
+#include "util/format.h"
+#include "util/ring_buffer.h"
+#include "util/switch.h"
+
+namespace bench {
+
+// Same types as used in the firmware
+using EventQueue = util::RingBuffer<MicroBench, ui::Event, 8>;
+using RxBuffer = util::RingBuffer<MicroBench, char, 64>;
+using Encoder = util::Encoder<0, 1>;
+using Switch = util::Switch<2>;
+
+// One detent worth of quadrature states
+static constexpr uint8_t kEncoderSequence[] = {0x00, 0x01, 0x03, 0x02};
+
+// Typical console input
+static const char line_short[] PROGMEM = "cd play 5";
+static const char line_comment[] PROGMEM = "set volume 40 # comment";
+static const char line_max[] PROGMEM = "  a b c d e f g h i";  // More than kMaxTokens
+
+static void RingBufferBenchmarks()
+{
+  MicroBench::Run(PSTR("ringbuffer_push"), [](uint16_t n) {
+    while (n--) RxBuffer::Push((char)n);
+  });
+  MicroBench::Run(PSTR("ringbuffer_pop"), [](uint16_t n) {
+    while (n--) MicroBench::DoNotOptimize(RxBuffer::Pop());
+  });
+  MicroBench::Run(PSTR("ringbuffer_push_pop"), [](uint16_t n) {
+    while (n--) {
+      RxBuffer::Push((char)n);
+      MicroBench::DoNotOptimize(RxBuffer::Pop());
+    }
+  });
+  MicroBench::Run(PSTR("eventqueue_emplace"), [](uint16_t n) {
+    while (n--) EventQueue::Emplace(ui::EVENT_ENCODER, (uint8_t)5, (int8_t)n);
+  });
+  MicroBench::Run(PSTR("eventqueue_pop"), [](uint16_t n) {
+    while (n--) MicroBench::DoNotOptimize(EventQueue::Pop().control.value);
+  });
+}
+
+static void EncoderBenchmarks()
+{
+  MicroBench::Run(PSTR("encoder_update"), [](uint16_t n) {
+    while (n--) MicroBench::DoNotOptimize(Encoder::Update(kEncoderSequence[n & 0x3]));
+  });
+  MicroBench::Run(PSTR("encoder_update_idle"), [](uint16_t n) {
+    while (n--) MicroBench::DoNotOptimize(Encoder::Update(0x00));
+  });
+}
+
+static void SwitchBenchmarks()
+{
+  // Update + edge check, as in UI::PollInputs
+  MicroBench::Run(PSTR("switch_debounce"), [](uint16_t n) {
+    while (n--) {
+      Switch::Update(n & 0x8 ? 0x04 : 0x00);
+      MicroBench::DoNotOptimize(Switch::just_pressed() || Switch::just_released());
+    }
+  });
+}
+
+// Tokenize modifies the line, so each op includes a copy from PROGMEM which is measured separately
+// and subtracted.
+static char line_buffer[64];
+
+static void Tokenize(const char *name, const char *pline)
+{
+  auto copy = MicroBench::Measure([pline](uint16_t n) {
+    while (n--) {
+      strcpy_P(line_buffer, pline);
+      MicroBench::DoNotOptimize(line_buffer[0]);
+    }
+  });
+  MicroBench::Run(
+      name,
+      [pline](uint16_t n) {
+        while (n--) {
+          strcpy_P(line_buffer, pline);
+          MicroBench::DoNotOptimize(util::CommandTokenizer::Tokenize(line_buffer).num_tokens);
+        }
+      },
+      copy);
+}
+
+static void TokenizerBenchmarks()
+{
+  Tokenize(PSTR("tokenize_line_short"), line_short);
+  Tokenize(PSTR("tokenize_line_comment"), line_comment);
+  Tokenize(PSTR("tokenize_line_max"), line_max);
+}
+
+// CDPlayer status line while playing, util::FormatTo vs. the libc version it replaced.
+// NOTE On the AVR vfprintf takes ~2k cycles per line, so a batch is well over 16 bits of Timer1.
+static_assert(sizeof(MicroBench::Ticks) >= 4, "format_status_sprintf needs 32-bit ticks");
+static char status_buffer[40];
+
+static void FormatBenchmarks()
+{
+  MicroBench::Run(PSTR("format_status_sprintf"), [](uint16_t n) {
+    while (n--) {
+      sprintf_P(status_buffer, PSTR("%3u %3u:%02u.%02u"), n, n & 0x7f, n & 0x3f, n & 0x3f);
+      MicroBench::DoNotOptimize(status_buffer[0]);
+    }
+  });
+  MicroBench::Run(PSTR("format_status"), [](uint16_t n) {
+    while (n--) {
+      util::FormatTo(status_buffer, FMT_P("%3u %3u:%02u.%02u"), n, n & 0x7f, n & 0x3f, n & 0x3f);
+      MicroBench::DoNotOptimize(status_buffer[0]);
+    }
+  });
+}
+
+void UtilBenchmarks()
+{
+  RingBufferBenchmarks();
+  EncoderBenchmarks();
+  SwitchBenchmarks();
+  TokenizerBenchmarks();
+  FormatBenchmarks();
+}
+
+}  // namespace bench
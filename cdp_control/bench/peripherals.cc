@@ -0,0 +1,276 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "peripherals.h"
+
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_spi.h>
+#include <simavr/avr_twi.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_irq.h>
+
+#include "drivers/dsa.h"
+#include "host/dsa_peer.h"
+
+namespace bench {
+
+// MCP23S17
+
+static constexpr uint8_t kMcpGPIOA = 0x12;
+static constexpr uint8_t kMcpGPIOB = 0x13;
+static constexpr uint8_t kMcpOLATB = 0x15;
+
+void Mcp23s17::Attach(avr_t *avr)
+{
+  avr_ = avr;
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), OnSpiOutput,
+                          this);
+}
+
+void Mcp23s17::Poll()
+{
+  bool selected = !driven_level(avr_, kDDRC, kPORTC, 0);
+  if (selected != selected_) {
+    selected_ = selected;
+    if (selected)
+      index_ = 0;
+    else
+      ++transactions;
+  }
+}
+
+/*static*/ void Mcp23s17::OnSpiOutput(struct avr_irq_t *, uint32_t value, void *param)
+{
+  auto mcp = static_cast<Mcp23s17 *>(param);
+  uint8_t response = 0;
+  if (mcp->selected_) {
+    switch (mcp->index_) {
+      case 0: mcp->control_ = value; break;
+      case 1: mcp->address_ = value % sizeof(mcp->registers_); break;
+      default:
+        // IOCON.SEQOP is set by the firmware, so the address doesn't increment
+        if (mcp->control_ & 0x1) {
+          response = kMcpGPIOA == mcp->address_ ? mcp->inputs : mcp->registers_[mcp->address_];
+        } else {
+          mcp->registers_[mcp->address_] = value;
+          if (kMcpGPIOB == mcp->address_ || kMcpOLATB == mcp->address_) mcp->outputs = value;
+        }
+        break;
+    }
+    ++mcp->index_;
+  }
+  avr_raise_irq(avr_io_getirq(mcp->avr_, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT), response);
+}
+
+// VFD
+
+void Vfd::Attach(avr_t *avr)
+{
+  avr_ = avr;
+  avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 0), 0);  // !BUSY
+}
+
+void Vfd::Poll()
+{
+  uint8_t e = driven_level(avr_, kDDRB, kPORTB, 2);
+  if (e_ && !e) ++nibbles;
+  e_ = e;
+}
+
+// SRC4392
+
+void Src4392::Attach(avr_t *avr)
+{
+  avr_ = avr;
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), OnTwiOutput,
+                          this);
+}
+
+/*static*/ void Src4392::OnTwiOutput(struct avr_irq_t *, uint32_t value, void *param)
+{
+  auto src = static_cast<Src4392 *>(param);
+  auto input = avr_io_getirq(src->avr_, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+
+  avr_twi_msg_irq_t msg;
+  msg.u.v = value;
+  if (msg.u.twi.msg & TWI_COND_STOP) {
+    if (src->selected_) ++src->transactions;
+    src->selected_ = false;
+  }
+
+  if (msg.u.twi.msg & TWI_COND_ADDR) {
+    // A repeated start for reading keeps the register address
+    src->selected_ = kAddress == (msg.u.twi.addr >> 1);
+    if (src->selected_) {
+      if (!(msg.u.twi.addr & 0x1)) src->addressed_ = false;
+      avr_raise_irq(input, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+    }
+  }
+
+  if (!src->selected_) return;
+  if (msg.u.twi.msg & TWI_COND_WRITE) {
+    avr_raise_irq(input, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+    if (!src->addressed_) {
+      src->register_ = msg.u.twi.data & 0x7f;
+      src->addressed_ = true;
+    } else {
+      src->registers[src->register_] = msg.u.twi.data;
+      src->register_ = (src->register_ + 1) & 0x7f;
+    }
+  }
+  if (msg.u.twi.msg & TWI_COND_READ) {
+    avr_raise_irq(input, avr_twi_irq_msg(TWI_COND_READ, msg.u.twi.addr,
+                                         src->registers[src->register_]));
+    src->register_ = (src->register_ + 1) & 0x7f;
+  }
+}
+
+// DSA
+
+enum DsaLine : uint8_t { DATA, ACK, STROBE };
+static constexpr uint8_t kDsaPin0 = 1;  // PC1
+static constexpr uint32_t kDsaResyncMillis = 300;
+
+void DsaLink::Attach(avr_t *avr)
+{
+  avr_ = avr;
+  pulled_ = 0x7;
+  for (uint8_t line = DATA; line <= STROBE; ++line) Pull(line, false);
+}
+
+void DsaLink::Pull(uint8_t line, bool low)
+{
+  uint8_t mask = 1 << line;
+  if (low == !!(pulled_ & mask)) return;
+  if (low)
+    pulled_ |= mask;
+  else
+    pulled_ &= ~mask;
+  avr_raise_irq(avr_io_getirq(avr_, AVR_IOCTL_IOPORT_GETIRQ('C'), kDsaPin0 + line), !low);
+}
+
+void DsaLink::SetState(State state, uint32_t now)
+{
+  state_ = state;
+  state_millis_ = now;
+}
+
+// The MCU side of the protocol is in drivers/dsa.cc; this is the mirror image of that. We only
+// react to changes the MCU makes to the lines.
+void DsaLink::Poll(uint32_t now)
+{
+  uint8_t lines = 0;
+  for (uint8_t line = DATA; line <= STROBE; ++line) {
+    if (driven_level(avr_, kDDRC, kPORTC, kDsaPin0 + line)) lines |= 1 << line;
+  }
+  uint8_t fell = lines_ & ~lines;
+  uint8_t rose = ~lines_ & lines;
+  lines_ = lines;
+
+  using cdp::host::DsaPeer;
+  switch (state_) {
+    case IDLE:
+      if (fell & (1 << DATA)) {
+        Pull(ACK, true);
+        SetState(RX_SYNC, now);
+      } else if (DsaPeer::transmit_requested()) {
+        Pull(DATA, true);
+        SetState(TX_REQUEST, now);
+      }
+      return;
+
+    case RX_SYNC:
+      if (rose & (1 << DATA)) {
+        Pull(ACK, false);
+        message_ = 0;
+        bit_ = 16;
+        state_ = RX_BITS;
+      }
+      break;
+
+    case RX_BITS:
+      if (fell & (1 << STROBE)) {
+        message_ = (message_ << 1) | !!(lines & (1 << DATA));
+        Pull(ACK, true);
+      } else if (rose & (1 << STROBE)) {
+        Pull(ACK, false);
+        if (!--bit_) state_ = RX_ACK;
+      }
+      break;
+
+    case RX_ACK:
+      if (fell & (1 << ACK)) {
+        // DATA signals the result, \sa DSA::Transmit
+        ++messages_rx;
+        Pull(DATA, cdp::DSA::STATUS_OK != DsaPeer::Transmit(message_));
+        Pull(STROBE, true);
+      } else if (rose & (1 << ACK)) {
+        Pull(DATA, false);
+        Pull(STROBE, false);
+        SetState(IDLE, now);
+      }
+      break;
+
+    case TX_REQUEST:
+      if (fell & (1 << ACK)) {
+        message_ = DsaPeer::Receive().message;
+        Pull(DATA, false);
+      } else if (rose & (1 << ACK)) {
+        bit_ = 16;
+        Pull(DATA, !(message_ & (1 << (bit_ - 1))));
+        Pull(STROBE, true);
+        state_ = TX_BITS;
+      }
+      break;
+
+    case TX_BITS:
+      if (fell & (1 << ACK)) {
+        Pull(STROBE, false);
+      } else if (rose & (1 << ACK)) {
+        if (--bit_) {
+          Pull(DATA, !(message_ & (1 << (bit_ - 1))));
+          Pull(STROBE, true);
+        } else {
+          Pull(DATA, false);
+          Pull(ACK, true);
+          state_ = TX_ACK;
+        }
+      }
+      break;
+
+    case TX_ACK:
+      if (fell & (1 << STROBE)) {
+        ++messages_tx;
+        Pull(ACK, false);
+        SetState(IDLE, now);
+      }
+      break;
+  }
+
+  // The MCU gives up after kDSATimeoutMS, so should we
+  if (IDLE != state_ && now - state_millis_ > kDsaResyncMillis) {
+    for (uint8_t line = DATA; line <= STROBE; ++line) Pull(line, false);
+    ++resyncs;
+    SetState(IDLE, now);
+  }
+}
+
+}  // namespace bench
@@ -0,0 +1,138 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef BENCH_PERIPHERALS_H_
+#define BENCH_PERIPHERALS_H_
+
+#include <simavr/sim_avr.h>
+#include <stdint.h>
+
+// simavr models of the peripherals on the cdp_control board, just enough to run the unmodified
+// firmware and count what's going on. Pin level stuff is polled after every instruction (\sa
+// Poll) since that's simpler than chaining into simavr's ioport callbacks and fast enough.
+
+namespace bench {
+
+// ATmega328P data space addresses
+static constexpr uint16_t kPINB = 0x23, kDDRB = 0x24, kPORTB = 0x25;
+static constexpr uint16_t kPINC = 0x26, kDDRC = 0x27, kPORTC = 0x28;
+static constexpr uint16_t kPIND = 0x29, kDDRD = 0x2a, kPORTD = 0x2b;
+static constexpr uint16_t kSPL = 0x5d, kSPH = 0x5e;
+
+// The level the MCU is driving a pin at, or 1 if it's an input (everything relevant has pullups)
+inline uint8_t driven_level(const avr_t *avr, uint16_t ddr, uint16_t port, uint8_t bit)
+{
+  return (avr->data[ddr] & (1 << bit)) ? !!(avr->data[port] & (1 << bit)) : 1;
+}
+
+// MCP23S17 on SPI with CS = PC0. Port A are the switch/encoder inputs, port B the LEDs/relays.
+class Mcp23s17 {
+public:
+  void Attach(avr_t *avr);
+  void Poll();
+
+  uint8_t inputs = 0xff;  // Nothing pressed
+  uint8_t outputs = 0;
+  uint32_t transactions = 0;
+
+private:
+  avr_t *avr_ = nullptr;
+  bool selected_ = false;
+  uint8_t index_ = 0;
+  uint8_t control_ = 0;
+  uint8_t address_ = 0;
+  uint8_t registers_[0x16] = {0};
+
+  static void OnSpiOutput(struct avr_irq_t *irq, uint32_t value, void *param);
+};
+
+// GU280x16 on PORTB (RS = PB1, E = PB2) and PORTD (D4-D7). Bytes are latched on the falling edge
+// of E, two nibbles each. BUSY (PB0) is never asserted.
+class Vfd {
+public:
+  void Attach(avr_t *avr);
+  void Poll();
+
+  uint32_t nibbles = 0;
+  uint32_t bytes() const { return nibbles / 2; }
+
+private:
+  avr_t *avr_ = nullptr;
+  uint8_t e_ = 0;
+};
+
+// SRC4392 on TWI at 0x70. Just a register file with auto-increment.
+class Src4392 {
+public:
+  static constexpr uint8_t kAddress = 0x70;
+
+  void Attach(avr_t *avr);
+
+  uint32_t transactions = 0;
+  uint8_t registers[0x80] = {0};
+
+private:
+  avr_t *avr_ = nullptr;
+  bool selected_ = false;
+  bool addressed_ = false;
+  uint8_t register_ = 0;
+
+  static void OnTwiOutput(struct avr_irq_t *irq, uint32_t value, void *param);
+};
+
+// Pin level DSA (PC1 = DATA, PC2 = ACK, PC3 = STROBE) in front of the message level CD-Pro2
+// simulation from the host build (\sa host/dsa_peer.h). The relay outputs of the MCP23S17 power
+// the drive.
+class DsaLink {
+public:
+  void Attach(avr_t *avr);
+  void Poll(uint32_t now);
+
+  uint32_t messages_rx = 0;  // From the MCU
+  uint32_t messages_tx = 0;  // To the MCU
+  uint32_t resyncs = 0;
+
+private:
+  enum State : uint8_t {
+    IDLE,
+    RX_SYNC,
+    RX_BITS,
+    RX_ACK,
+    TX_REQUEST,
+    TX_BITS,
+    TX_ACK,
+  };
+
+  avr_t *avr_ = nullptr;
+  State state_ = IDLE;
+  uint32_t state_millis_ = 0;
+  uint8_t lines_ = 0x7;  // As seen on the bus
+  uint8_t pulled_ = 0;   // Lines we're pulling low
+  uint16_t message_ = 0;
+  uint8_t bit_ = 0;
+
+  void Pull(uint8_t line, bool low);
+  void SetState(State state, uint32_t now);
+};
+
+}  // namespace bench
+
+#endif  // BENCH_PERIPHERALS_H_
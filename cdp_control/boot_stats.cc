@@ -0,0 +1,201 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "boot_stats.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+
+#include "avrx/macros.h"
+#include "avrx/progmem.h"
+#include "serial_console.h"
+#include "util/cobs.h"
+
+namespace cdp {
+
+namespace {
+
+struct ResetCounters {
+  uint16_t boots;
+  uint8_t resets[BootStats::RESET_CAUSE_LAST];
+  uint8_t crc;
+
+  uint8_t calc_crc() const
+  {
+    return util::Crc8(reinterpret_cast<const uint8_t *>(this), sizeof(ResetCounters) - 1);
+  }
+};
+
+struct CrashRecord {
+  uint16_t boot;  // ResetCounters::boots at the time of the crash
+  uint16_t pc;    // Byte address, i.e. as in the .lss
+  uint16_t sp;    // At ISR entry, i.e. below the return address
+  uint8_t boot_phase;
+  uint8_t bus_op;
+  uint16_t bus_arg;
+  uint8_t crc;
+
+  uint8_t calc_crc() const
+  {
+    return util::Crc8(reinterpret_cast<const uint8_t *>(this), sizeof(CrashRecord) - 1);
+  }
+};
+
+// NOTE .noinit is placed after .bss so it isn't touched by the stack paint either
+ResetCounters reset_counters __attribute__((section(".noinit")));
+CrashRecord crash_record __attribute__((section(".noinit")));
+
+bool crashed = false;  // The last reset was a watchdog reset with a capture
+
+}  // namespace
+
+/*static*/ void BootStats::Init(uint8_t mcusr)
+{
+  // After a power-on the RAM contents are random; if the CRC happens to match anyway the counters
+  // are still restarted.
+  auto &counters = reset_counters;
+  if ((mcusr & _BV(PORF)) || counters.crc != counters.calc_crc()) {
+    counters.boots = 0;
+    for (auto &r : counters.resets) r = 0;
+  }
+
+  // The record is only current if it was captured during the previous boot; a watchdog reset with
+  // interrupts disabled wouldn't have updated it.
+  crashed = (mcusr & _BV(WDRF)) && crash_record.crc == crash_record.calc_crc() &&
+            crash_record.boot == counters.boots;
+
+  ++counters.boots;
+  for (uint8_t cause = 0; cause < RESET_CAUSE_LAST; ++cause) {
+    if ((mcusr & _BV(cause)) && counters.resets[cause] < 0xff) ++counters.resets[cause];
+  }
+  counters.crc = counters.calc_crc();
+}
+
+/*static*/ void BootStats::EnableWatchdog()
+{
+  wdt_enable(WDTO_1S);
+  WDTCSR |= _BV(WDIE);  // Unlike WDE this doesn't need the timed sequence
+}
+
+PROGMEM_STRINGS5(bus_op_names, "-", "i2c", "i2c_stop", "dsa_rx", "dsa_tx");
+static_assert(BUS_OP_LAST == 5);
+
+// Same order as BOOT_PHASE, plus the UI running
+static const char boot_phase_names[BOOT_PHASE_LAST + 1][9] PROGMEM = {
+    "settings", "console", "vfd",     "mcp23s17", "irmp", "adc",
+    "i2c",      "src4392", "cdplayer", "display", "ui",   "running",
+};
+
+static void PrintCrash()
+{
+  const auto &crash = crash_record;
+  SerialConsole::Print(FMT_P("wdt pc %04x sp %04x in %S, last %S %04x"), crash.pc, crash.sp,
+                       boot_phase_names[crash.boot_phase],
+                       avrx::pgm_read(&bus_op_names[crash.bus_op]), crash.bus_arg);
+}
+
+/*static*/ void BootStats::ReportCrash()
+{
+  if (crashed) PrintCrash();
+}
+
+/*static*/ uint16_t BootStats::boots()
+{
+  return reset_counters.boots;
+}
+
+/*static*/ uint8_t BootStats::resets(RESET_CAUSE cause)
+{
+  return reset_counters.resets[cause];
+}
+
+// Timer1 wraps after 65536 ticks (~839ms), converted to SysTick millis (1/1024 s) with a millis
+// of margin for the quantization of the phase times.
+static constexpr uint16_t kMaxUsPhaseMillis = 0x10000UL * Timer1::kPrescaler / (F_CPU / 1024) - 1;
+
+static bool PrintBoot(const util::CommandTokenizer::Tokens &)
+{
+  // The phases are sequential so the delta to the previous one is what it took; except the display
+  // reset which is started in the VFD phase and finishes in the main loop. The microseconds are
+  // only shown for phases shorter than a Timer1 wrap.
+  uint16_t last_millis = 0;
+  uint16_t last_ticks = 0;
+  for (uint8_t phase = 0; phase < BOOT_PHASE_LAST; ++phase) {
+    const uint16_t millis = debug_info.boot_millis[phase];
+    const uint16_t ticks = debug_info.boot_ticks[phase];
+    uint16_t start_millis = last_millis;
+    uint16_t start_ticks = last_ticks;
+    if (BOOT_PHASE_DISPLAY == phase) {
+      start_millis = debug_info.boot_millis[BOOT_PHASE_VFD];
+      start_ticks = debug_info.boot_ticks[BOOT_PHASE_VFD];
+    } else {
+      last_millis = millis;
+      last_ticks = ticks;
+    }
+
+    const uint16_t delta_millis = millis - start_millis;
+    if (delta_millis < kMaxUsPhaseMillis) {
+      SerialConsole::Print(FMT_P("%-8S %5u %5u %7u us"), boot_phase_names[phase], millis,
+                           delta_millis, Timer1::TicksToUs(ticks - start_ticks));
+    } else {
+      SerialConsole::Print(FMT_P("%-8S %5u %5u"), boot_phase_names[phase], millis, delta_millis);
+    }
+  }
+  SerialConsole::Print(FMT_P("mcusr %02x flags %02x"), debug_info.mcusr, debug_info.boot_flags);
+  SerialConsole::Print(FMT_P("boots %u por %u ext %u bor %u wdt %u"), BootStats::boots(),
+                       BootStats::resets(BootStats::RESET_POWER_ON),
+                       BootStats::resets(BootStats::RESET_EXTERNAL),
+                       BootStats::resets(BootStats::RESET_BROWN_OUT),
+                       BootStats::resets(BootStats::RESET_WATCHDOG));
+  if (crashed) PrintCrash();
+  return true;
+}
+CCMD(boot, 0, PrintBoot);
+
+// The first watchdog timeout ends up here with WDIE cleared by the hardware, so the next timeout
+// resets. Rather than waiting for that the watchdog is restarted with the shortest timeout.
+static void CaptureCrash(const uint8_t *sp) __attribute__((noreturn, noinline, used));
+static void CaptureCrash(const uint8_t *sp)
+{
+  auto &crash = crash_record;
+  crash.boot = reset_counters.boots;
+  crash.pc = ((sp[1] << 8) | sp[2]) << 1;  // Return address is pushed low byte first, in words
+  crash.sp = reinterpret_cast<uintptr_t>(sp);
+  crash.boot_phase = debug_info.boot_phase;
+  crash.bus_op = debug_info.bus_op;
+  crash.bus_arg = debug_info.bus_arg;
+  crash.crc = crash.calc_crc();
+
+  wdt_enable(WDTO_15MS);
+  for (;;) {}
+}
+
+// Naked since it never returns, so there's nothing to save and SP still points at the return
+// address. The interrupted code might have been in the middle of a mul though.
+ISR(WDT_vect, ISR_NAKED)
+{
+  asm volatile("clr __zero_reg__");
+  CaptureCrash(reinterpret_cast<const uint8_t *>(SP));
+}
+
+}  // namespace cdp
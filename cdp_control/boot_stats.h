@@ -0,0 +1,72 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef BOOT_STATS_H_
+#define BOOT_STATS_H_
+
+#include <stdint.h>
+
+#include "cdp_debug.h"
+#include "drivers/systick.h"
+#include "drivers/timer.h"
+
+namespace cdp {
+
+// Boot phase timestamps (in debug_info) and counters of the reset causes from MCUSR. The counters
+// live in .noinit so they survive everything except a power cycle, which resets them. The `boot`
+// command shows both.
+//
+// The watchdog runs in interrupt-then-reset mode: the first timeout runs an ISR that saves the
+// interrupted PC, SP, boot phase and last bus operation into .noinit before the reset, so a hang
+// (e.g. a blocking I2C wait) is reported at the next boot. A hang with interrupts disabled still
+// resets without a capture.
+class BootStats {
+public:
+  enum RESET_CAUSE : uint8_t {
+    RESET_POWER_ON,  // Matches the MCUSR bit positions
+    RESET_EXTERNAL,
+    RESET_BROWN_OUT,
+    RESET_WATCHDOG,
+    RESET_CAUSE_LAST,
+  };
+
+  static void Init(uint8_t mcusr);
+
+  // Enables the watchdog in interrupt-then-reset mode
+  static void EnableWatchdog();
+
+  // Prints the crash capture if the last reset was caused by one
+  static void ReportCrash();
+
+  static inline void PhaseDone(BOOT_PHASE phase)
+  {
+    debug_info.boot_millis[phase] = SysTick::millis();
+    debug_info.boot_ticks[phase] = Timer1::ticks();
+    debug_info.boot_phase = phase + 1;
+  }
+
+  static uint16_t boots();
+  static uint8_t resets(RESET_CAUSE cause);
+};
+
+}  // namespace cdp
+
+#endif  // BOOT_STATS_H_
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "boot_stats.h"
 #include "cdp_debug.h"
 #include "cdpro2.h"
 #include "drivers/adc.h"
@@ -40,27 +41,31 @@
 #include "drivers/timer.h"
 #include "drivers/vfd.h"
 #include "menus/menus.h"
+#include "ram_monitor.h"
 #include "remote_codes.h"
 #include "resources/resources.h"
 #include "serial_console.h"
 #include "settings.h"
+#include "settings_store.h"
 #include "src4392.h"
 #include "timer_slots.h"
+#include "topics.h"
 #include "ui/ui.h"
 
-// TODO There's something up with the init order. sei is enabled last, which means the serial port
-// doesn't TX until then. Duh :) But enabling it earlier seems to cause some hiccups.
+// TODO There's something up with the init order. sei used to be enabled last, which means the
+// serial port doesn't TX until then. Duh :) It's now enabled first so the display reset can run in
+// parallel and the boot phases have timestamps; keep an eye out for the hiccups it caused earlier.
 // TODO Some kind of timeout if no events or updates? => turn off display
 //
 // NOTE We might check MCUSR for the reset reason, and be less aggressive about switching off the
-// relays. That might a "development" problem though.
+// relays. That might a "development" problem though. The causes are counted, \sa BootStats.
 
 namespace cdp {
 GlobalState global_state;
 DebugInfo debug_info;
 
 CVAR_RO(lid_open, &global_state.lid_open);
-CVAR_RW(disp_lum, &global_state.disp_brightness);
+CVAR_RW(disp_lum, &global_state.user_brightness);
 // CVAR_RO(mcusr, &debug_info.mcusr);
 // CVAR_RO(boot, &debug_info.boot_flags);
 
@@ -73,45 +78,70 @@ CVAR_RO(src_freq, &global_state.src4392.ratio);
 using namespace cdp;
 using ui::UI;
 
-static void UpdateGlobalState()
+// Subscribers, \sa topics.h
+void cdp::ApplyInput(int8_t input)
 {
-  // TODO we should probabably pub/sub these values
-  CoverSensor::set_threshold(Settings::get_value(SETTING_SENSOR_THRESHOLD));
+  global_state.src4392.source = input ? SOURCE_DIR : SOURCE_I2S;
+}
 
-  SRC4392::Update(global_state.src4392);
-  if (global_state.src4392.mute) {
+void cdp::ApplyMute(bool mute)
+{
+  if (mute)
     gpio::MUTE::reset();
-    UI::set_led(UI::LED_MUTE, true);
-  } else {
+  else
     gpio::MUTE::set();
-    UI::set_led(UI::LED_MUTE, false);
-  }
+  UI::set_led(UI::LED_MUTE, mute);
+}
+
+void cdp::ApplyBrightness(uint8_t)
+{
+  global_state.restore_brightness();
+}
+
+static void UpdateGlobalState()
+{
+  // The SRC writes are batched per loop rather than each change going straight to I2C
+  if (SRCState::dirty(SRCState::DIRTY_SRC_CONTROL)) SRC4392::Update(global_state.src4392);
 }
 
 PROGMEM const char boot_msg[] = "CDPFW " CDPFW_VERSION_STRING;
 
+// SysTick runs from the start of Init for the boot timestamps, but the rest of the ISR has to wait
+// until the MCP23S17, IRMP and ADC are ready.
+static volatile bool systick_poll = false;
+
 static void Init()
 {
   debug_info.mcusr = MCUSR;
-  wdt_enable(WDTO_1S);
+  MCUSR = 0;
+  BootStats::Init(debug_info.mcusr);
+  BootStats::EnableWatchdog();
+
+  Timer1::Init();  // Used by DSA + I2C, and for the boot timestamps
+  SysTick::Init();
+  sei();
 
   Settings::InitDefaults();
+  SettingsStore::Restore();
+  BootStats::PhaseDone(BOOT_PHASE_SETTINGS);
+
   SerialConsole::Init();
+  BootStats::ReportCrash();
+  BootStats::PhaseDone(BOOT_PHASE_CONSOLE);
 
-  VFD::Init(VFD::POWER_OFF, global_state.disp_brightness);
-  VFD::PrintfP(boot_msg);
-  VFD::SetPowerState(VFD::POWER_ON);
+  // The display reset is finished from the main loop, \sa UpdateVFDInit. The slots are otherwise
+  // only ticked there, so they need the current time before arming.
+  const auto vfd_init_ms = VFD::BeginInit(VFD::POWER_OFF, global_state.disp_brightness);
+  TimerSlots::Tick(SysTick::millis());
+  TimerSlots::Arm(TIMER_SLOT_VFD_INIT, SysTick::MsToMillis(vfd_init_ms));
+  BootStats::PhaseDone(BOOT_PHASE_VFD);
 
   gpio::MUTE::Init();
   MCP23S17::Init(MCP23S17_OUTPUT_INIT);
-
-  Timer1::Init();  // Used by DSA + I2C
-  I2C::Init();
-  if (I2C::Stop()) debug_info.boot_flags |= I2C_OK;  // This doesn't actually mean much?
-  if (SRC4392::Init()) debug_info.boot_flags |= SRC_OK;
-  if (CDPlayer::Init()) debug_info.boot_flags |= CDP_OK;
+  BootStats::PhaseDone(BOOT_PHASE_MCP23S17);
 
   irmp_init();
+  BootStats::PhaseDone(BOOT_PHASE_IRMP);
 
   Adc::Init(kAdcChannel, Adc::LEFT_ALIGN);  // 8-bit
   Adc::Enable(true);
@@ -123,26 +153,73 @@ static void Init()
 #else
   global_state.lid_open = false;
 #endif
+  systick_poll = true;
+  BootStats::PhaseDone(BOOT_PHASE_ADC);
 
-  SysTick::Init();
-  sei();
+  I2C::Init();
+  if (I2C::Stop()) debug_info.boot_flags |= I2C_OK;  // This doesn't actually mean much?
+  BootStats::PhaseDone(BOOT_PHASE_I2C);
+
+  if (SRC4392::Init()) debug_info.boot_flags |= SRC_OK;
+  BootStats::PhaseDone(BOOT_PHASE_SRC4392);
+
+  if (CDPlayer::Init()) debug_info.boot_flags |= CDP_OK;
+  BootStats::PhaseDone(BOOT_PHASE_CDPLAYER);
+}
+
+static uint16_t last_draw_millis_ = 0;
+static uint16_t last_tick_millis_ = 0;
+
+static void UpdateVFDInit(uint16_t millis)
+{
+  auto ms = VFD::InitStep();
+  if (ms) {
+    TimerSlots::Arm(TIMER_SLOT_VFD_INIT, SysTick::MsToMillis(ms));
+  } else {
+    TimerSlots::Reset(TIMER_SLOT_VFD_INIT);
+    VFD::PrintP(boot_msg);
+    VFD::SetPowerState(VFD::POWER_ON);
+    // TODO Small WTF here, without a message (delay?) graphics mode on VFD fails? So the first draw
+    // waits for the next redraw.
+    last_draw_millis_ = millis;
+    BootStats::PhaseDone(BOOT_PHASE_DISPLAY);
+  }
 }
 
 static bool ProcessIRMP(const ui::Event &event)
 {
 #ifdef DEBUG_IRMP
-  SERIAL_TRACE(PSTR("%5u IR{%02x, %04x, %04x, %02x}"), event.millis, event.irmp_data.protocol,
+  SERIAL_TRACE_P("%5u IR{%02x, %04x, %04x, %02x}", event.millis, event.irmp_data.protocol,
                event.irmp_data.address, event.irmp_data.command, event.irmp_data.flags);
 #endif
+  // Scanning relies on the repeats while the key is held
+  switch (event.irmp_data.command) {
+    case Remote::SKIP_BACK: CDPlayer::Scan(-1); return true;
+    case Remote::SKIP_FWD: CDPlayer::Scan(1); return true;
+    default: break;
+  }
+
   if (IRMP_FLAG_REPETITION & event.irmp_data.flags) return true;  // Ignore repeats for now
   switch (event.irmp_data.command) {
     case Remote::OFF: CDPlayer::TogglePower(); break;
     case Remote::PLAY: CDPlayer::Play(); break;
     case Remote::STOP: CDPlayer::Stop(); break;
+    case Remote::JUMP_BACK: CDPlayer::PrevTitle(); break;
+    case Remote::JUMP_FWD: CDPlayer::NextTitle(); break;
+    case Remote::NUM0:
+    case Remote::NUM1:
+    case Remote::NUM2:
+    case Remote::NUM3:
+    case Remote::NUM4:
+    case Remote::NUM5:
+    case Remote::NUM6:
+    case Remote::NUM7:
+    case Remote::NUM8:
+    case Remote::NUM9: CDPlayer::EnterDigit(event.irmp_data.command - Remote::NUM0); break;
     case Remote::MUTE: global_state.src4392.toggle_mute(); break;
     case Remote::INFO: Menus::set_current(&menu_debug); break;
     case Remote::DISP:
-      global_state.disp_brightness = (global_state.disp_brightness + 1) & 0x3;
+      global_state.user_brightness = (global_state.user_brightness + 1) & 0x3;
       break;
     case Remote::UP:
       global_state.src4392.attenuation = util::clamp(global_state.src4392.attenuation - 1, 0, 255);
@@ -155,9 +232,6 @@ static bool ProcessIRMP(const ui::Event &event)
   return true;
 }
 
-static uint16_t last_draw_millis_ = 0;
-static uint16_t last_tick_millis_ = 0;
-
 [[noreturn]] void Run()
 {
   // The general plan for the main loop is
@@ -197,6 +271,15 @@ static uint16_t last_tick_millis_ = 0;
       TimerSlots::Arm(TIMER_SLOT_SRC_READRATIO, kReadRatioTimoutMS);
       global_state.src4392.ratio = SRC4392::ReadRatio();
     }
+    if (TimerSlots::elapsed(TIMER_SLOT_RAM_CHECK)) {
+      TimerSlots::Arm(TIMER_SLOT_RAM_CHECK, kRamCheckMs);
+      RamMonitor::Check();
+    }
+    if (TimerSlots::elapsed(TIMER_SLOT_VFD_INIT)) UpdateVFDInit(millis);
+    if (TimerSlots::elapsed(TIMER_SLOT_SETTINGS_STORE)) {
+      TimerSlots::Reset(TIMER_SLOT_SETTINGS_STORE);
+      SettingsStore::Save();
+    }
 
     // NOTE TimerSlots::Tick uses absolute time, but the rest use the elapsed time.
     auto elapsed_millis = millis - last_tick_millis_;
@@ -218,6 +301,8 @@ static uint16_t last_tick_millis_ = 0;
       }
     }
 
+    SerialConsole::UpdateWatches(millis);
+
     // Clear all the dirties here at the end
     global_state.lid_open.clear();
     global_state.src4392.clear_dirty();
@@ -240,9 +325,10 @@ static uint16_t last_tick_millis_ = 0;
 __attribute__((OS_main)) int main()
 {
   Init();
-  // TODO Small WTF here, without a message (delay?) graphics mode on VFD fails?
-  SerialConsole::PrintfP(PSTR("%S"), boot_msg);
+  SerialConsole::Print(FMT_P("%S"), boot_msg);
 
+  Settings::PublishAll();
+  global_state.src4392.mute.publish();
   global_state.src4392.force_dirty();
   UpdateGlobalState();
 
@@ -250,6 +336,7 @@ __attribute__((OS_main)) int main()
   Menus::Init();
 
   TimerSlots::Arm(TIMER_SLOT_SRC_READRATIO, kReadRatioTimoutMS);
+  TimerSlots::Arm(TIMER_SLOT_RAM_CHECK, kRamCheckMs);
 
   Run();
 }
@@ -260,6 +347,7 @@ SYSTICK_ISR()
   avrx::ScopedPulse<gpio::MUTE, avrx::GPIO_SET> mute_pulse{};
 #endif
   auto tick = SysTick::Tick();
+  if (!systick_poll) return;
   uint8_t sub_tick = tick & 0x7;
 
   UI::PollIR();
@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 #include "src_state.h"
+#include "util/scratch_arena.h"
 #include "util/utils.h"
 
 namespace cdp {
@@ -42,6 +43,11 @@ static constexpr uint16_t kVolumeOverlayTimeoutMS = 5000;
 static constexpr uint16_t kSourceInfoTimeoutMS = 5000;
 
 static constexpr uint16_t kReadRatioTimoutMS = 1000;
+static constexpr uint16_t kTrackEntryTimeoutMS = 1500;
+static constexpr uint16_t kScanReleaseTimeoutMS = 250;  // > RC5 repeat
+
+static constexpr uint16_t kRamCheckMs = 1000;
+static constexpr uint16_t kSettingsStoreDelayMs = 5000;  // After the last change
 
 static constexpr uint8_t kAdcChannel = 7;
 
@@ -50,12 +56,28 @@ static constexpr uint32_t kSrcSampleRateK = 96LU;
 static constexpr uint32_t kSrcSampleRate = kSrcSampleRateK * 1000LU;
 
 struct GlobalState {
-  util::Variable<bool> lid_open{false};
-  util::Variable<uint8_t> disp_brightness{0};
+  using Dirty = util::DirtyMask<GlobalState>;
+  enum DirtyBits : uint8_t {
+    DIRTY_LID_OPEN = 0x01,
+    DIRTY_DISP_BRIGHTNESS = 0x02,
+  };
+
+  util::GroupVariable<Dirty, bool, DIRTY_LID_OPEN> lid_open{false};
+  // The display shows disp_brightness; the splash and overlays override it temporarily and then
+  // return to the (persisted) user_brightness that the DISP key sets.
+  util::GroupVariable<Dirty, uint8_t, DIRTY_DISP_BRIGHTNESS> disp_brightness{0};
+  util::Variable<uint8_t, BrightnessTopic> user_brightness{0};
   SRCState src4392;
+
+  inline void restore_brightness() { disp_brightness = user_brightness; }
 };
 extern GlobalState global_state;
 
+// Short-lived buffers in the main loop, \sa util/scratch_arena.h. The deepest nesting is a console
+// command that traces, i.e. a trace record (40) and its encoded frame (44).
+static constexpr uint8_t kScratchSize = 96;
+using Scratch = util::ScratchArena<GlobalState, kScratchSize>;
+
 }  // namespace cdp
 
 #endif  // CDP_CONTROL_H_
@@ -26,18 +26,56 @@
 
 namespace cdp {
 
+// SysTick::millis and Timer1::ticks at the end of each boot phase, \sa BootStats
+enum BOOT_PHASE : uint8_t {
+  BOOT_PHASE_SETTINGS,  // Defaults + EEPROM restore
+  BOOT_PHASE_CONSOLE,
+  BOOT_PHASE_VFD,  // Display reset started
+  BOOT_PHASE_MCP23S17,
+  BOOT_PHASE_IRMP,
+  BOOT_PHASE_ADC,  // Including the first cover sensor reading
+  BOOT_PHASE_I2C,
+  BOOT_PHASE_SRC4392,
+  BOOT_PHASE_CDPLAYER,  // Init() done, i.e. everything except the display
+  BOOT_PHASE_DISPLAY,   // Display reset done
+  BOOT_PHASE_UI,        // Main menu, i.e. the UI is usable
+  BOOT_PHASE_LAST,
+};
+
+// The last I2C/DSA operation started, for the watchdog crash capture (\sa BootStats)
+enum BUS_OP : uint8_t {
+  BUS_OP_NONE,
+  BUS_OP_I2C_START,  // arg = SLA+R/W
+  BUS_OP_I2C_STOP,
+  BUS_OP_DSA_RECEIVE,
+  BUS_OP_DSA_TRANSMIT,  // arg = message
+  BUS_OP_LAST,
+};
+
 struct DebugInfo {
   uint8_t boot_flags = 0;
   uint8_t src_init = 0;
   uint8_t mcusr = 0;
+  uint8_t boot_phase = 0;  // Phase in progress, BOOT_PHASE_LAST once the UI is up
+  uint16_t boot_millis[BOOT_PHASE_LAST] = {0};
+  uint16_t boot_ticks[BOOT_PHASE_LAST] = {0};  // For the short phases
+  uint8_t bus_op = BUS_OP_NONE;
+  uint16_t bus_arg = 0;
 };
 extern DebugInfo debug_info;
 
+inline void SetBusOp(BUS_OP op, uint16_t arg = 0)
+{
+  debug_info.bus_op = op;
+  debug_info.bus_arg = arg;
+}
+
 enum BOOT_FLAG : uint8_t {
   I2C_OK = 0x1,
   SRC_OK = 0x2,
   CDP_OK = 0x4,
   SENSOR_OK = 0x8,
+  STACK_LOW = 0x10,  // Not really boot, \sa RamMonitor
 };
 
 }  // namespace cdp
@@ -21,13 +21,15 @@
 //
 #include "cdpro2.h"
 
-#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "avrx/macros.h"
 #include "cdp_control.h"
 #include "drivers/dsa.h"
 #include "drivers/relays.h"
+#include "drivers/systick.h"
+#include "resume_memory.h"
 #include "serial_console.h"
 #include "timer_slots.h"
 #include "util/ring_buffer.h"
@@ -61,18 +63,41 @@ namespace cdp {
 
 /*static*/ CDPro2::TOC CDPro2::toc_ = {};
 /*static*/ CDPro2::Actual CDPro2::actual_ = {};
+/*static*/ CDPro2::MSF CDPro2::absolute_ = {};
 /*static*/ CDPro2::DiscState CDPro2::disc_state_ = {};
+/*static*/ CDPro2::PlayClock CDPro2::title_clock_ = {};
+/*static*/ CDPro2::PlayClock CDPro2::disc_clock_ = {};
 ///*static*/ uint8_t CDPro2::disc_id_[5] = {0};
 
 /*static*/ CDPlayer::PowerState CDPlayer::power_state_ = CDPlayer::POWER_OFF;
 /*static*/ uint8_t CDPlayer::power_sequence_ = 0;
 
+/*static*/ CDPlayer::StartupPhase CDPlayer::startup_phase_ = CDPlayer::STARTUP_DONE;
+/*static*/ uint16_t CDPlayer::startup_millis_ = 0;
+/*static*/ uint16_t CDPlayer::startup_times_[CDPlayer::STARTUP_DONE] = {0};
+/*static*/ uint8_t CDPlayer::requested_title_ = 0;
+/*static*/ uint8_t CDPlayer::resume_title_ = 0;
+/*static*/ uint8_t CDPlayer::track_entry_ = 0;
+/*static*/ uint8_t CDPlayer::track_entry_digits_ = 0;
+/*static*/ uint32_t CDPlayer::scan_target_ = 0;
+/*static*/ uint16_t CDPlayer::scan_start_ = 0;
+/*static*/ int8_t CDPlayer::scan_direction_ = 0;
+/*static*/ bool CDPlayer::scan_pending_ = false;
+
+static_assert(sizeof(CDPro2::TOC::data_) == ResumeMemory::kDiscIdLength);
+
 /*static*/ util::RingBuffer<CDPlayer, CDPlayer::QueuedAction, 8> CDPlayer::queued_actions_;
 
 /*static*/ CDPlayer::AsyncCommand CDPlayer::async_command_ = {};
 
 /*static*/ uint16_t CDPlayer::animation_ticks_ = 0;
 /*static*/ char CDPlayer::status_[40] = {0};
+/*static*/ uint32_t CDPlayer::status_frames_ = 0;
+
+// ACTUAL_* only has whole seconds, so the prediction may be ahead by up to a second. The
+// ABSOLUTE_TIME_* values include frames and we only allow for some DSA latency.
+static constexpr uint8_t kActualTolerance = CDPro2::MSF::kFramesPerSecond;
+static constexpr uint8_t kAbsoluteTolerance = 4;
 
 // VFD-specific chars
 PROGMEM static const char kBusyAnimationChars[16] = {
@@ -89,7 +114,13 @@ static inline char busy_animation(uint16_t ticks)
 PROGMEM_STRINGS4(power_state_strings, "OFF", "UP", "DOWN", "ON");
 const char *to_pstring(CDPlayer::PowerState ps)
 {
-  return (PGM_P)pgm_read_word(&(power_state_strings[ps]));
+  return avrx::pgm_read(&power_state_strings[ps]);
+}
+
+PROGMEM_STRINGS4(startup_phase_strings, "POWER", "SPIN_UP", "TOC", "PLAY");
+const char *to_pstring(CDPlayer::StartupPhase phase)
+{
+  return avrx::pgm_read(&startup_phase_strings[phase]);
 }
 
 static util::Variable<bool> cdplayer_debug{false};
@@ -98,13 +129,27 @@ static util::Variable<bool> cdplayer_debug{false};
     if (cdplayer_debug) SERIAL_TRACE_P(__VA_ARGS__); \
   } while (0)
 
+// SET_MODE is passed through as-is (\sa DSA docs for the bits). The main use is lowering the rate
+// of ACTUAL_* updates since the play position is interpolated locally anyway.
+static util::Variable<uint8_t> cdplayer_mode{0};
+static bool cdplayer_mode_set = false;
+
 static bool SerialCommand(const util::CommandTokenizer::Tokens &tokens)
 {
-  if (!strcmp_P(tokens[0], PSTR("stop"))) {
+  if (!strcmp_P(tokens[1], PSTR("stop"))) {
     CDPlayer::Stop();
     return true;
-  } else if (!strcmp_P(tokens[0], PSTR("play"))) {
-    CDPlayer::Play();
+  } else if (!strcmp_P(tokens[1], PSTR("play"))) {
+    CDPlayer::PlayTitle(tokens.num_tokens > 2 ? atoi(tokens[2]) : 0);
+    return true;
+  } else if (!strcmp_P(tokens[1], PSTR("power"))) {
+    CDPlayer::TogglePower();
+    return true;
+  } else if (!strcmp_P(tokens[1], PSTR("startup"))) {
+    CDPlayer::PrintStartupTimes();
+    return true;
+  } else if (!strcmp_P(tokens[1], PSTR("mode")) && tokens.num_tokens > 2) {
+    CDPlayer::SetMode(strtoul(tokens[2], nullptr, 16));
     return true;
   }
 
@@ -112,12 +157,70 @@ static bool SerialCommand(const util::CommandTokenizer::Tokens &tokens)
 }
 CCMD(cd, 1, SerialCommand);
 CVAR_RW(cd_debug, &cdplayer_debug);
+CVAR_RO(cd_mode, &cdplayer_mode);
+
+uint32_t CDPro2::MSF::to_frames() const
+{
+  return ((uint32_t)minutes() * 60 + seconds()) * kFramesPerSecond + frames();
+}
+
+CDPro2::MSF CDPro2::MSF::FromFrames(uint32_t frames)
+{
+  uint32_t seconds = frames / kFramesPerSecond;
+  uint8_t f = frames - seconds * kFramesPerSecond;
+  uint8_t m = seconds / 60;
+  uint8_t s = seconds - m * 60U;
+  return {{m, s, f}};
+}
+
+uint32_t CDPro2::PlayClock::position(uint16_t now) const
+{
+  if (!running) return frames;
+  uint16_t elapsed = now - sample_millis;
+  return frames + (((uint32_t)elapsed * MSF::kFramesPerSecond) >> 10);
+}
+
+void CDPro2::PlayClock::Start(uint16_t now)
+{
+  sample_millis = now;
+  running = true;
+}
+
+void CDPro2::PlayClock::Stop(uint16_t now)
+{
+  frames = position(now);
+  running = false;
+}
+
+void CDPro2::PlayClock::Update(uint16_t now)
+{
+  // Whole seconds fold without loss, and 8s leaves plenty of headroom for the 16-bit millis
+  static constexpr uint16_t kFoldSeconds = 8;
+  if (running && (uint16_t)(now - sample_millis) >= kFoldSeconds * 1024U) {
+    frames += kFoldSeconds * MSF::kFramesPerSecond;
+    sample_millis += kFoldSeconds * 1024U;
+  }
+}
+
+bool CDPro2::PlayClock::Sync(uint32_t reported, uint16_t now, uint8_t tolerance)
+{
+  auto predicted = position(now);
+  if (predicted >= reported && predicted - reported < tolerance) return false;
+
+  frames = reported;
+  sample_millis = now;
+  synced = true;
+  return true;
+}
 
 void CDPro2::ResetDiscState()
 {
   toc_ = {};
   actual_ = {};
+  absolute_ = {};
   disc_state_ = {};
+  title_clock_ = {};
+  disc_clock_ = {};
 }
 
 bool CDPlayer::Init()
@@ -131,12 +234,19 @@ bool CDPlayer::Init()
 void CDPlayer::Tick(uint16_t ticks)
 {
   animation_ticks_ += ticks;
+  if (track_entry_digits_ && TimerSlots::elapsed(TIMER_SLOT_CD_ENTRY)) CommitTrackEntry();
+  if (scan_direction_ && TimerSlots::elapsed(TIMER_SLOT_CD_SCAN)) {
+    TimerSlots::Reset(TIMER_SLOT_CD_SCAN);
+    scan_direction_ = 0;
+  }
+
   if (powered()) {
     // Check lid state
     if (global_state.lid_open.dirty()) {
       if (global_state.lid_open) {
+        SaveResumePosition();
         StopImmediate();
-        sprintf_P(status_, PSTR("OPEN"));
+        util::FormatTo(status_, FMT_P("OPEN"));
       } else {
         ReadTOC();
       }
@@ -145,7 +255,7 @@ void CDPlayer::Tick(uint16_t ticks)
     if (DSA::TransmitRequested()) {
       auto result = DSA::Receive();
       if (DSA::STATUS_OK != result.dsa_status) {
-        CDP_SERIAL_TRACE_P(PSTR("RX %S"), to_pstring(result.dsa_status));
+        CDP_SERIAL_TRACE_P("RX %S", to_pstring(result.dsa_status));
       } else {
         HandleResponse(result.message);
       }
@@ -155,12 +265,33 @@ void CDPlayer::Tick(uint16_t ticks)
       DispatchAction(queued_actions_.Pop());
     }
 
+    // Only one seek in flight, everything requested meanwhile just moves the target
+    if (scan_pending_ && !async_command_.valid()) {
+      scan_pending_ = false;
+      GotoTime(MSF::FromFrames(scan_target_));
+    }
+
+    if (cdplayer_mode.dirty() && !async_command_.valid()) {
+      StartAsyncCommand(SET_MODE, cdplayer_mode, HandleResponseSetMode);
+      cdplayer_mode.clear();
+    }
+
+    auto now = SysTick::millis();
+    title_clock_.Update(now);
+    disc_clock_.Update(now);
+    if (disc_state_.playing && !disc_state_.paused) {
+      UpdatePlayStatus(now);
+    }
+
   } else {
     // Not powered... but we might have a powr sequence running
     if (POWER_OFF != power_state_ && TimerSlots::elapsed(TIMER_SLOT_CD_POWER)) {
       switch (PowerSequence()) {
         case POWER_OFF: break;
-        case POWER_ON: ReadTOC(); break;
+        case POWER_ON:
+          if (cdplayer_mode_set) cdplayer_mode.force_dirty();
+          SpinUp();
+          break;
         default: break;
       }
     }
@@ -170,9 +301,22 @@ void CDPlayer::Tick(uint16_t ticks)
 void CDPlayer::GetStatus(char *buffer)
 {
   auto buf = buffer;
+  const auto end = buffer + kStatusLength;
 
   if (global_state.lid_open) {
-    sprintf_P(buf, PSTR(" LID OPEN"));
+    util::FormatTo(buf, end, FMT_P(" LID OPEN"));
+    return;
+  }
+
+  if (track_entry_digits_) {
+    util::FormatTo(buf, end, FMT_P(" TRACK %u_"), track_entry_);
+    return;
+  }
+
+  if (scan_direction_) {
+    auto msf = MSF::FromFrames(scan_target_);
+    util::FormatTo(buf, end, FMT_P(" %S %3u:%02u"),
+                   scan_direction_ > 0 ? PSTR(">>") : PSTR("<<"), msf.minutes(), msf.seconds());
     return;
   }
 
@@ -182,11 +326,10 @@ void CDPlayer::GetStatus(char *buffer)
     *buf++ = disc_state_.stopped ? 'S' : '_';
     *buf++ = disc_state_.playing ? 'P' : '_';
     *buf++ = disc_state_.paused ? 'Z' : '_';
-    buf += sprintf_P(buf, PSTR(" %s"), status_);
+    buf = util::FormatTo(buf, end, FMT_P(" %s"), status_);
   } else {
     switch (power_state_) {
-        // buf += sprintf_P(buf, to_pstring(power_state_));
-      case POWER_OFF: buf += sprintf_P(buf, PSTR(" %S"), to_pstring(power_state_)); break;
+      case POWER_OFF: buf = util::FormatTo(buf, end, FMT_P(" %S"), to_pstring(power_state_)); break;
       default: *buf++ = busy_animation(animation_ticks_); break;
     }
   }
@@ -195,8 +338,21 @@ void CDPlayer::GetStatus(char *buffer)
 
 void CDPlayer::Play()
 {
-  if (!powered() || global_state.lid_open) return;
-  queued_actions_.Emplace(ACTION_PLAY, (uint8_t)0);
+  PlayTitle(0);
+}
+
+void CDPlayer::PlayTitle(uint8_t title)
+{
+  if (global_state.lid_open) return;
+
+  // While powering up there's nothing to queue to yet, but the startup goes straight from reading
+  // the TOC into the requested title.
+  if (POWER_UP == power_state_) {
+    requested_title_ = title;
+    return;
+  }
+  if (!powered()) return;
+  queued_actions_.Emplace(ACTION_PLAY, title);
 }
 
 void CDPlayer::Stop()
@@ -205,6 +361,8 @@ void CDPlayer::Stop()
 
   // Stop is inelegant and just barges ahead of everything so we don't care about much except power
   // (even if those errors might be masked).
+  // An explicit stop also means the next load starts from the beginning.
+  if (disc_state_.loaded) ResumeMemory::Forget(toc_.data_);
   StopImmediate();
 }
 
@@ -226,17 +384,115 @@ void CDPlayer::PrevTitle()
   queued_actions_.Emplace(ACTION_PREV_TITLE, (uint8_t)0);
 }
 
+void CDPlayer::SetMode(uint8_t mode)
+{
+  cdplayer_mode = mode;
+  cdplayer_mode.force_dirty();
+  cdplayer_mode_set = true;
+}
+
+// Scan steps grow the longer a key is held (or the encoder keeps turning)
+struct ScanStep {
+  avrx::ProgmemVariable<uint16_t> hold_ms;
+  avrx::ProgmemVariable<uint8_t> seconds;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanStep);
+};
+
+static PROGMEM constexpr ScanStep kScanSteps[] = {
+    {0, 2}, {1024, 5}, {3072, 15}, {6144, 30}, {10240, 60},
+};
+
+void CDPlayer::Scan(int8_t direction)
+{
+  if (!powered() || global_state.lid_open || !disc_state_.playing || !direction) return;
+
+  auto now = SysTick::millis();
+  TimerSlots::Arm(TIMER_SLOT_CD_SCAN, kScanReleaseTimeoutMS);
+
+  // Without a known disc time there's nowhere to go to, but skipping titles is better than nothing.
+  if (!disc_clock_.synced) {
+    if (!scan_direction_) {
+      if (direction > 0)
+        NextTitle();
+      else
+        PrevTitle();
+    }
+    scan_direction_ = direction;
+    return;
+  }
+
+  if (!scan_direction_ || (direction > 0) != (scan_direction_ > 0)) {
+    scan_start_ = now;
+    // The disc clock is synced to the target of a seek in flight (\sa GotoTime), so it's valid even
+    // while a command is outstanding; only a seek that hasn't been sent yet is further along.
+    if (!scan_pending_) scan_target_ = disc_clock_.position(now);
+  }
+  scan_direction_ = direction;
+
+  uint16_t hold_ms = now - scan_start_;
+  uint32_t step = 0;
+  for (const auto &scan_step : kScanSteps) {
+    if (hold_ms >= scan_step.hold_ms) step = scan_step.seconds;
+  }
+  step *= MSF::kFramesPerSecond;
+
+  // Stay clear of the lead-in and lead-out
+  const uint32_t min_frames = 2 * MSF::kFramesPerSecond;
+  const uint32_t max_frames =
+      MSF{{toc_.disc_time_minutes(), toc_.disc_time_seconds(), toc_.disc_time_frames()}}
+          .to_frames() - MSF::kFramesPerSecond;
+  if (direction > 0)
+    scan_target_ = scan_target_ + step < max_frames ? scan_target_ + step : max_frames;
+  else
+    scan_target_ = scan_target_ > min_frames + step ? scan_target_ - step : min_frames;
+  scan_pending_ = true;
+}
+
+void CDPlayer::EnterDigit(uint8_t digit)
+{
+  if (global_state.lid_open || !(powered() || POWER_UP == power_state_)) return;
+
+  // The TOC limits what's possible, otherwise (e.g. still powering up) it's anything up to 99
+  uint8_t max_title = disc_state_.loaded ? toc_.max_track_number() : 99;
+  uint8_t entry = track_entry_digits_ ? track_entry_ * 10 + digit : digit;
+  if (entry > max_title) entry = digit;  // Start over
+
+  track_entry_ = entry;
+  ++track_entry_digits_;
+  if (entry && (uint16_t)entry * 10 > max_title)
+    CommitTrackEntry();
+  else
+    TimerSlots::Arm(TIMER_SLOT_CD_ENTRY, kTrackEntryTimeoutMS);
+}
+
+void CDPlayer::CommitTrackEntry()
+{
+  TimerSlots::Reset(TIMER_SLOT_CD_ENTRY);
+  auto title = track_entry_;
+  track_entry_ = track_entry_digits_ = 0;
+
+  if (disc_state_.loaded && (title < toc_.min_track_number() || title > toc_.max_track_number()))
+    return;
+  if (title) PlayTitle(title);
+}
+
 void CDPlayer::TogglePower()
 {
   // This only allows changing to on/off from the off/on states.
 
   if (powered()) {
-    CDP_SERIAL_TRACE_P(PSTR("CD: power off"));
+    CDP_SERIAL_TRACE_P("CD: power off");
+    SaveResumePosition();
     StopImmediate();
     power_state_ = POWER_DOWN;
     PowerSequence();
   } else if (POWER_OFF == power_state_ && !global_state.lid_open) {
-    CDP_SERIAL_TRACE_P(PSTR("CD: power on"));
+    CDP_SERIAL_TRACE_P("CD: power on");
+    memset(startup_times_, 0, sizeof(startup_times_));
+    startup_phase_ = STARTUP_POWER;
+    startup_millis_ = SysTick::millis();
+    requested_title_ = 0;
     power_state_ = POWER_UP;
     PowerSequence();
   }
@@ -248,14 +504,26 @@ void CDPlayer::DispatchAction(const QueuedAction &action)
   switch (action.action_type) {
     case ACTION_PLAY:
       if (disc_state_.loaded) {
-        if (!disc_state_.playing)
+        if (action.param) {
+          if (action.param >= toc_.min_track_number() && action.param <= toc_.max_track_number())
+            StartAsyncCommand(PLAY_TITLE, action.param, HandleResponsePlay);
+        } else if (!disc_state_.playing)
           StartAsyncCommand(PLAY_TITLE, toc_.min_track_number(), HandleResponsePlay);
         else if (disc_state_.paused)
           StartAsyncCommand(PAUSE_RELEASE, 0, HandleResponsePause);
       } else {
+        requested_title_ = action.param;
         ReadTOC();
       }
       break;
+    case ACTION_NEXT_TITLE:
+      if (disc_state_.playing && actual_.title() < toc_.max_track_number())
+        StartAsyncCommand(PLAY_TITLE, actual_.title() + 1, HandleResponsePlay);
+      break;
+    case ACTION_PREV_TITLE:
+      if (disc_state_.playing && actual_.title() > toc_.min_track_number())
+        StartAsyncCommand(PLAY_TITLE, actual_.title() - 1, HandleResponsePlay);
+      break;
       // case ACTION PAUSE:
       // If not loaded or not playing, do nothing
       // paused = !paused
@@ -263,16 +531,21 @@ void CDPlayer::DispatchAction(const QueuedAction &action)
   }
 }
 
-void CDPlayer::StartAsyncCommand(Opcode opcode, uint8_t param,
-                                 AsyncCommand::ResponseHandler response_handler)
+DSA::DSA_STATUS CDPlayer::Transmit(Opcode opcode, uint8_t param)
 {
   auto dsa_message = DSA::Pack(opcode, param);
   auto dsa_status = DSA::Transmit(dsa_message);
   if (DSA::STATUS_OK != dsa_status) {
-    sprintf_P(status_, PSTR("TX %04X %S"), dsa_message, to_pstring(dsa_status));
-    CDP_SERIAL_TRACE_P(PSTR("%s"), status_);
+    util::FormatTo(status_, FMT_P("TX %04X %S"), dsa_message, to_pstring(dsa_status));
+    CDP_SERIAL_TRACE_P("%s", status_);
   }
+  return dsa_status;
+}
 
+void CDPlayer::StartAsyncCommand(Opcode opcode, uint8_t param,
+                                 AsyncCommand::ResponseHandler response_handler)
+{
+  auto dsa_status = Transmit(opcode, param);
   async_command_ = {opcode, param, response_handler, dsa_status};
   animation_ticks_ = 0;
 }
@@ -282,13 +555,45 @@ void CDPlayer::EndAsyncCommand()
   async_command_ = {};
 }
 
+void CDPlayer::AdvanceStartup(StartupPhase phase)
+{
+  // Only the phase we're expecting moves things along, so e.g. a TOC read after closing the lid
+  // doesn't get mixed into the power up numbers.
+  if (phase != startup_phase_) return;
+
+  auto now = SysTick::millis();
+  startup_times_[phase] = now - startup_millis_;
+  startup_millis_ = now;
+  startup_phase_ = static_cast<StartupPhase>(phase + 1);
+  CDP_SERIAL_TRACE_P("CD: %S %u", to_pstring(phase), startup_times_[phase]);
+}
+
+void CDPlayer::PrintStartupTimes()
+{
+  uint16_t total = 0;
+  for (uint8_t phase = STARTUP_POWER; phase < STARTUP_DONE; ++phase) {
+    auto t = startup_times_[phase];
+    SerialConsole::Print(FMT_P("%-8S %5u"), to_pstring(static_cast<StartupPhase>(phase)), t);
+    total += t;
+  }
+  SerialConsole::Print(FMT_P("%-8S %5u%S"), PSTR("TOTAL"), total,
+                       STARTUP_DONE == startup_phase_ ? PSTR("") : PSTR(" ..."));
+}
+
+void CDPlayer::SpinUp()
+{
+  AdvanceStartup(STARTUP_POWER);
+  StartAsyncCommand(SPIN_UP, 0, HandleResponseSpinUp);
+  util::FormatTo(status_, FMT_P("SPIN UP..."));
+}
+
 void CDPlayer::ReadTOC()
 {
   if (global_state.lid_open) return;
 
   ResetDiscState();
   StartAsyncCommand(READ_TOC, 0, HandleResponseReadTOC);
-  sprintf_P(status_, PSTR("READ TOC..."));
+  util::FormatTo(status_, FMT_P("READ TOC..."));
 }
 
 void CDPlayer::StopImmediate()
@@ -300,22 +605,94 @@ void CDPlayer::StopImmediate()
   disc_state_.stopped = true;
   disc_state_.playing = false;
   disc_state_.paused = false;
+  title_clock_ = {};
+  disc_clock_ = {};
+  resume_title_ = 0;
   if (disc_state_.loaded) {
     auto num_tracks = toc_.num_tracks();
-    sprintf_P(status_, PSTR("%2d %S %3u:%02u"), num_tracks,
-              num_tracks > 1 ? PSTR("tracks") : PSTR("track"), toc_.disc_time_minutes(),
-              toc_.disc_time_seconds());
+    util::FormatTo(status_, FMT_P("%2d %S %3u:%02u"), num_tracks,
+                   num_tracks > 1 ? PSTR("tracks") : PSTR("track"), toc_.disc_time_minutes(),
+                   toc_.disc_time_seconds());
   } else {
-    sprintf_P(status_, PSTR("???"));
+    util::FormatTo(status_, FMT_P("???"));
   }
   queued_actions_.Clear();
+  startup_phase_ = STARTUP_DONE;
+  scan_pending_ = false;
+  scan_direction_ = 0;
+}
+
+void CDPlayer::StartClocks()
+{
+  auto now = SysTick::millis();
+  title_clock_.Start(now);
+  disc_clock_.Start(now);
+}
+
+void CDPlayer::StopClocks()
+{
+  auto now = SysTick::millis();
+  title_clock_.Stop(now);
+  disc_clock_.Stop(now);
+}
+
+void CDPlayer::UpdatePlayStatus(uint16_t now)
+{
+  // Only re-format if the displayed value actually changes
+  auto frames = title_clock_.position(now);
+  if (frames != status_frames_) {
+    status_frames_ = frames;
+    auto msf = MSF::FromFrames(frames);
+    util::FormatTo(status_, FMT_P("%3u %3u:%02u.%02u"), actual_.title(), msf.minutes(),
+                   msf.seconds(), msf.frames());
+  }
+}
+
+void CDPlayer::GotoTime(const MSF &msf)
+{
+  // The target takes three messages and only the last one starts the search, so if either of the
+  // first two fails we stop rather than seeking somewhere else.
+  // TODO Retries? So far we only get a response to the last one.
+  if (DSA::STATUS_OK != Transmit(GOTO_TIME_MINUTES, msf.minutes())) return;
+  if (DSA::STATUS_OK != Transmit(GOTO_TIME_SECONDS, msf.seconds())) return;
+  StartAsyncCommand(GOTO_TIME_FRAMES, msf.frames(), HandleResponsePlay);
+
+  // We know where we're going, the title clock follows with the next ACTUAL_*
+  disc_clock_ = {};
+  disc_clock_.Sync(msf.to_frames(), SysTick::millis(), 0);
+}
+
+void CDPlayer::SaveResumePosition()
+{
+  // This is called on power off, opening the lid and when the title changes, but not periodically
+  // while playing: the time always changes so each save really writes the disc's slot, and at 100k
+  // cycles that wears out after a few thousand hours of play.
+  if (!disc_state_.loaded || !disc_state_.playing || !actual_.title()) return;
+  resume_title_ = actual_.title();
+
+  ResumeMemory::Record record;
+  memcpy(record.disc_id, toc_.data_, sizeof(record.disc_id));
+  record.title = actual_.title();
+  if (disc_clock_.synced) {
+    auto msf = MSF::FromFrames(disc_clock_.position(SysTick::millis()));
+    memcpy(record.msf, msf.data_, sizeof(record.msf));
+  } else {
+    memset(record.msf, 0, sizeof(record.msf));
+  }
+  ResumeMemory::Store(record);
 }
 
 void CDPlayer::SetFound(uint8_t param)
 {
   switch (param) {
-    case 0x41: disc_state_.paused = true; break;
-    case 0x42: disc_state_.paused = false; break;
+    case 0x41:
+      disc_state_.paused = true;
+      StopClocks();
+      break;
+    case 0x42:
+      disc_state_.paused = false;
+      StartClocks();
+      break;
 
     case 0x40:  // Goto time
     case 0x43:  // spin up
@@ -333,7 +710,9 @@ void CDPlayer::HandleResponsePlay(Response response, uint8_t)
     case FOUND:
       disc_state_.stopped = false;
       disc_state_.playing = true;
+      StartClocks();
       EndAsyncCommand();
+      AdvanceStartup(STARTUP_PLAY);
       break;
 
     default: return;
@@ -348,6 +727,15 @@ void CDPlayer::HandleResponsePause(Response response, uint8_t)
   }
 }
 
+void CDPlayer::HandleResponseSpinUp(Response response, uint8_t param)
+{
+  if (FOUND == response && 0x43 == param) {
+    EndAsyncCommand();
+    AdvanceStartup(STARTUP_SPIN_UP);
+    ReadTOC();
+  }
+}
+
 void CDPlayer::HandleResponseReadTOC(Response response, uint8_t param)
 {
   switch (response) {
@@ -368,8 +756,35 @@ void CDPlayer::HandleResponseReadTOC(Response response, uint8_t param)
     disc_state_.loaded = true;
     EndAsyncCommand();
 
-    // After reading the TOC, the CD-module goes in pause mode at the beginning of the first track
-    StartAsyncCommand(PLAY_TITLE, toc_.min_track_number(), HandleResponsePlay);
+    AdvanceStartup(STARTUP_TOC);
+
+    // After reading the TOC, the CD-module goes in pause mode at the beginning of the first track.
+    // If something else was requested in the meantime we can go there directly.
+    // Otherwise pick up where this disc was left off last time, if we know.
+    auto title = toc_.min_track_number();
+    auto requested_title = requested_title_;
+    requested_title_ = 0;
+    ResumeMemory::Record record;
+    if (requested_title >= title && requested_title <= toc_.max_track_number()) {
+      title = requested_title;
+    } else if (ResumeMemory::Find(toc_.data_, record) && record.title >= title &&
+               record.title <= toc_.max_track_number()) {
+      util::FormatTo(status_, FMT_P("RESUME %u"), record.title);
+      if (record.has_time()) {
+        GotoTime(MSF{{record.msf[0], record.msf[1], record.msf[2]}});
+        return;
+      }
+      title = record.title;
+    }
+    StartAsyncCommand(PLAY_TITLE, title, HandleResponsePlay);
+  }
+}
+
+void CDPlayer::HandleResponseSetMode(Response response, uint8_t)
+{
+  switch (response) {
+    case MODE_STATUS: EndAsyncCommand(); break;
+    default: break;
   }
 }
 
@@ -393,10 +808,10 @@ void CDPlayer::HandleResponse(DSA::Message dsa_message)
     case ERROR_VALUES:
       if (NO_DISC == param) {
         ResetDiscState();
-        sprintf_P(status_, PSTR("NO DISC"));
+        util::FormatTo(status_, FMT_P("NO DISC"));
         default_handler = false;
       } else {
-        sprintf_P(status_, PSTR("ERR %02x"), param);
+        util::FormatTo(status_, FMT_P("ERR %02x"), param);
       };
       EndAsyncCommand();
       break;
@@ -405,11 +820,25 @@ void CDPlayer::HandleResponse(DSA::Message dsa_message)
     case ACTUAL_INDEX:
     case ACTUAL_MINUTES:
     case ACTUAL_SECONDS:
-      // The response to PLAY_TITLE is ACTUAL_* + FOUND, so we just want to cache these values
+      // The response to PLAY_TITLE is ACTUAL_* + FOUND, so we just want to cache these values.
+      // The values arrive in order, so the seconds complete a sample.
       actual_.data_[response - ACTUAL_TITLE] = param;
-      if (disc_state_.playing)
-        sprintf_P(status_, PSTR("%3u %3u:%02u"), actual_.title(), actual_.minutes(),
-                  actual_.seconds());
+      if (ACTUAL_SECONDS == response) {
+        auto reported = MSF{{actual_.minutes(), actual_.seconds(), 0}}.to_frames();
+        if (title_clock_.Sync(reported, SysTick::millis(), kActualTolerance))
+          CDP_SERIAL_TRACE_P("CD: sync %u:%02u", actual_.minutes(), actual_.seconds());
+        if (actual_.title() != resume_title_) SaveResumePosition();
+      }
+      status_frames_ = ~(uint32_t)0;  // force refresh
+      default_handler = false;
+      break;
+
+    case ABSOLUTE_TIME_MINUTES:
+    case ABSOLUTE_TIME_SECONDS:
+    case ABSOLUTE_TIME_FRAMES:
+      absolute_.data_[response - ABSOLUTE_TIME_MINUTES] = param;
+      if (ABSOLUTE_TIME_FRAMES == response)
+        disc_clock_.Sync(absolute_.to_frames(), SysTick::millis(), kAbsoluteTolerance);
       default_handler = false;
       break;
 
@@ -453,7 +882,7 @@ CDPlayer::PowerState CDPlayer::PowerSequence()
 
   const auto &step = POWER_UP == power_state_ ? kPowerSequenceUp[power_sequence_]
                                               : kPowerSequenceDown[power_sequence_];
-  CDP_SERIAL_TRACE_P(PSTR("CD: %d { n=%d, r=%u, s=%u, AC=%d, 9V=%d }"), power_sequence_,
+  CDP_SERIAL_TRACE_P("CD: %d { n=%d, r=%u, s=%u, AC=%d, 9V=%d }", power_sequence_,
                      step.next.read(), step.timeout.read(), step.state.read(), step.aux_ac.read(),
                      step.aux_9v.read());
 
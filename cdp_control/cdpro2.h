@@ -41,6 +41,10 @@ public:
     PAUSE = 0x04,
     PAUSE_RELEASE = 0x05,
     GET_TITLE_LENGTH = 0x09,
+    // Goto time is absolute disc time; the frames message triggers the search (FOUND 0x40)
+    GOTO_TIME_MINUTES = 0x0a,
+    GOTO_TIME_SECONDS = 0x0b,
+    GOTO_TIME_FRAMES = 0x0c,
     GET_COMPLETE_TIME = 0x0d,
     SET_MODE = 0x15,
     SPIN_UP = 0x18,
@@ -130,6 +134,44 @@ public:
     uint8_t data_[4] = {0, 0, 0, 0};  // NOTE Array in order of message IDs
   };
 
+  // Minutes/seconds/frames, in the same order as the ABSOLUTE_TIME_* responses
+  struct MSF {
+    static constexpr uint8_t kFramesPerSecond = 75;
+
+    inline uint8_t minutes() const { return data_[0]; }
+    inline uint8_t seconds() const { return data_[1]; }
+    inline uint8_t frames() const { return data_[2]; }
+
+    uint32_t to_frames() const;
+    static MSF FromFrames(uint32_t frames);
+
+    uint8_t data_[3] = {0, 0, 0};  // NOTE Array in order of message IDs
+  };
+
+  // Local model of a play position. The drive only pushes ACTUAL_* (title relative) or
+  // ABSOLUTE_TIME_* (disc) updates at its own reporting rate, and each of those costs a full DSA
+  // receive. In between the position is interpolated from SysTick, which also gets us frames.
+  //
+  // NOTE SysTick::millis are 1/1024s, so the time since the last sample is folded into the
+  // position regularly (\sa Update) to avoid the 16-bit wrap if reports are far apart.
+  struct PlayClock {
+    uint32_t frames = 0;         // Position at sample_millis
+    uint16_t sample_millis = 0;  // SysTick::millis at last sample
+    bool running = false;
+    bool synced = false;  // Has seen at least one sample
+
+    uint32_t position(uint16_t now) const;
+
+    void Start(uint16_t now);
+    void Stop(uint16_t now);
+    void Update(uint16_t now);
+
+    // Sync to a position reported by the drive. If the prediction is already within tolerance
+    // (i.e. ahead by less than the resolution of the report) we keep interpolating smoothly,
+    // otherwise the clock jumps. Returns true if a resync was required.
+    bool Sync(uint32_t reported, uint16_t now, uint8_t tolerance);
+  };
+
   // Try and keep track of what's going on, and what's being requested.
   // This might also be a queue, but DSA commands can override each other so that might be more
   // effort?
@@ -143,7 +185,11 @@ public:
 protected:
   static TOC toc_;
   static Actual actual_;
+  static MSF absolute_;
   static DiscState disc_state_;
+
+  static PlayClock title_clock_;
+  static PlayClock disc_clock_;
   // static uint8_t disc_id_[5];
 
   static void ResetDiscState();
@@ -156,15 +202,28 @@ public:
   // Menu/Status updates
   static bool Init();
   static void Tick(uint16_t ticks);
-  static void GetStatus(char* buffer);
+  static constexpr uint8_t kStatusLength = 40;
+  static void GetStatus(char* buffer);  // buffer[kStatusLength]
+  static inline util::RingBufferUsage queued_actions_usage() { return queued_actions_.usage(); }
 
   // User player controls
   static void Play();
+  static void PlayTitle(uint8_t title);  // 0 = first title
+
+  // Direct track entry, e.g. "1", "2" => PlayTitle(12) after a timeout or once no other track
+  // number is possible.
+  static void EnterDigit(uint8_t digit);
   static void Stop();
   static void Pause();
   static void NextTitle();
   static void PrevTitle();
 
+  // Seek while a key is held/the encoder turns. Repeated calls keep it going.
+  static void Scan(int8_t direction);
+
+  // Drive configuration, applied once the drive is idle
+  static void SetMode(uint8_t mode);
+
   // Power handling
   static void TogglePower();
   static bool powered() { return power_state_ == POWER_ON; }
@@ -172,10 +231,34 @@ public:
   // Our internal power states
   enum PowerState : uint8_t { POWER_OFF, POWER_UP, POWER_DOWN, POWER_ON };
 
+  // Time-to-play after power on is split into phases that run back-to-back without waiting for
+  // the main loop or user input; the duration of each is recorded for debugging.
+  enum StartupPhase : uint8_t {
+    STARTUP_POWER,
+    STARTUP_SPIN_UP,
+    STARTUP_TOC,
+    STARTUP_PLAY,
+    STARTUP_DONE,
+  };
+  static void PrintStartupTimes();
+
 private:
   static PowerState power_state_;
   static uint8_t power_sequence_;
 
+  static StartupPhase startup_phase_;
+  static uint16_t startup_millis_;
+  static uint16_t startup_times_[STARTUP_DONE];
+  static uint8_t requested_title_;
+  static uint8_t resume_title_;  // Title of the last SaveResumePosition
+  static uint8_t track_entry_;
+  static uint8_t track_entry_digits_;
+
+  static uint32_t scan_target_;
+  static uint16_t scan_start_;
+  static int8_t scan_direction_;
+  static bool scan_pending_;
+
   // Most user actions get queued in case there's a already some operation in progress
   enum ActionType : uint8_t { ACTION_PLAY, ACTION_PAUSE, ACTION_NEXT_TITLE, ACTION_PREV_TITLE };
   struct QueuedAction {
@@ -201,9 +284,11 @@ private:
   static AsyncCommand async_command_;
 
   static uint16_t animation_ticks_;
-  static char status_[40];
+  static char status_[kStatusLength];
+  static uint32_t status_frames_;
 
   static void DispatchAction(const QueuedAction& action);
+  static DSA::DSA_STATUS Transmit(Opcode opcode, uint8_t param);  // Shows TX errors
   static void StartAsyncCommand(Opcode opcode, uint8_t param,
                                 AsyncCommand::ResponseHandler response_handler);
   static void EndAsyncCommand();
@@ -212,13 +297,25 @@ private:
   struct PowerSequenceStep;
   static PowerState PowerSequence();
 
+  static void AdvanceStartup(StartupPhase phase);
+
+  static void SpinUp();
   static void ReadTOC();
   static void StopImmediate();
+  static void GotoTime(const MSF& msf);
+  static void CommitTrackEntry();
+  static void SaveResumePosition();
+
+  static void StartClocks();
+  static void StopClocks();
+  static void UpdatePlayStatus(uint16_t now);
 
   static void SetFound(uint8_t param);
   static void HandleResponsePlay(Response response, uint8_t param);
   static void HandleResponsePause(Response response, uint8_t param);
+  static void HandleResponseSpinUp(Response response, uint8_t param);
   static void HandleResponseReadTOC(Response response, uint8_t param);
+  static void HandleResponseSetMode(Response response, uint8_t param);
 };
 
 }  // namespace cdp
@@ -43,8 +43,9 @@
 // Using fixed-size strings avoids having to define the progmem strings in two steps (but makes
 // constructors difficult).
 //
-// TODO Can we sort cmds/vars in linker script?
-// This might mean expanding section to something like .ccvars.name
+// Each entry is placed in a section named after it (e.g. .cvars.name) and the linker script
+// collects them with SORT_BY_NAME, so both tables are sorted and lookup can use a binary search.
+// NOTE The section name order must match strcmp order, so names are plain identifiers.
 // TODO  How to handle enum types?
 // TODO RO/RW versions; these might even live in their own section.
 
@@ -55,39 +56,57 @@ static constexpr int kMaxCommandNameLen = 8;
 
 enum CVAR_TYPE : uint8_t { CVAR_NONE, CVAR_BOOL, CVAR_U8, CVAR_U16, CVAR_STR };
 
-// Having a value type simplifies the constructor of Variable
+// Having a value type simplifies the constructor of Variable.
+// The value is read directly, but writes go through the variable's own set() so that they mark it
+// dirty and are published like any other change. This works for both util::Variable and
+// util::GroupVariable since the value is their first member, i.e. the value pointer is also a
+// pointer to the variable.
 struct Value {
+  using Setter = void(void *, uint16_t);
+
   avrx::ProgmemVariable<CVAR_TYPE> type;
   union {
-    util::Variable<bool> *const var_bool;
-    util::Variable<uint8_t> *const var_u8;
-    util::Variable<uint16_t> *const var_u16;
+    bool *const var_bool;
+    uint8_t *const var_u8;
+    uint16_t *const var_u16;
     const char *const str;
   };
+  avrx::ProgmemFunction<Setter> setter;
 
   template <CVAR_TYPE cvar_type> auto read() const;
+  template <CVAR_TYPE cvar_type, typename T> void write(T value) const;
+  inline uint16_t raw() const;
 
-  constexpr explicit Value(util::Variable<bool> *ptr) : type{CVAR_BOOL}, var_bool{ptr} {}
-  constexpr explicit Value(util::Variable<uint8_t> *ptr) : type{CVAR_U8}, var_u8{ptr} {}
-  constexpr explicit Value(util::Variable<uint16_t> *ptr) : type{CVAR_U16}, var_u16(ptr) {}
-  constexpr explicit Value(char *ptr) : type{CVAR_STR}, str(ptr) {}
+  template <typename V> constexpr explicit Value(V *var) : Value(var->value_ptr(), &Set<V>) {}
+  constexpr explicit Value(char *ptr) : type{CVAR_STR}, str(ptr), setter{nullptr} {}
 
   DISALLOW_COPY_AND_ASSIGN(Value);
+
+private:
+  constexpr Value(bool *ptr, Setter *fn) : type{CVAR_BOOL}, var_bool{ptr}, setter{fn} {}
+  constexpr Value(uint8_t *ptr, Setter *fn) : type{CVAR_U8}, var_u8{ptr}, setter{fn} {}
+  constexpr Value(uint16_t *ptr, Setter *fn) : type{CVAR_U16}, var_u16{ptr}, setter{fn} {}
+
+  template <typename V> static void Set(void *var, uint16_t value)
+  {
+    using T = typename V::value_type;
+    reinterpret_cast<V *>(static_cast<T *>(var))->set(static_cast<T>(value));
+  }
 };
 
 template <> inline auto Value::read<CVAR_BOOL>() const
 {
-  return reinterpret_cast<util::Variable<bool> *>(pgm_read_ptr(&var_bool))->get();
+  return *reinterpret_cast<const bool *>(pgm_read_ptr(&var_bool));
 }
 
 template <> inline auto Value::read<CVAR_U8>() const
 {
-  return reinterpret_cast<util::Variable<uint8_t> *>(pgm_read_ptr(&var_u8))->get();
+  return *reinterpret_cast<const uint8_t *>(pgm_read_ptr(&var_u8));
 }
 
 template <> inline auto Value::read<CVAR_U16>() const
 {
-  return reinterpret_cast<util::Variable<uint16_t> *>(pgm_read_ptr(&var_u16))->get();
+  return *reinterpret_cast<const uint16_t *>(pgm_read_ptr(&var_u16));
 }
 
 template <> inline auto Value::read<CVAR_STR>() const
@@ -95,6 +114,33 @@ template <> inline auto Value::read<CVAR_STR>() const
   return reinterpret_cast<const char *>(pgm_read_ptr(&str));
 }
 
+// Scalar value, e.g. for detecting changes. Strings are returned as 0.
+inline uint16_t Value::raw() const
+{
+  switch (type) {
+    case CVAR_BOOL: return read<CVAR_BOOL>();
+    case CVAR_U8: return read<CVAR_U8>();
+    case CVAR_U16: return read<CVAR_U16>();
+    default: break;
+  }
+  return 0;
+}
+
+template <> inline void Value::write<CVAR_BOOL>(bool value) const
+{
+  setter(pgm_read_ptr(&var_bool), value);
+}
+
+template <> inline void Value::write<CVAR_U8>(uint8_t value) const
+{
+  setter(pgm_read_ptr(&var_u8), value);
+}
+
+template <> inline void Value::write<CVAR_U16>(uint16_t value) const
+{
+  setter(pgm_read_ptr(&var_u16), value);
+}
+
 struct Variable {
   enum FLAGS : uint8_t {
     FLAG_RO = 1,
@@ -128,15 +174,21 @@ struct Command {
 
 #define CVAR_RW(name, ptr)                                       \
   static constexpr console::Variable MACRO_PASTE(cvar_rw_, name) \
-      __attribute__((section(".cvars"), used)) = {#name, {0}, console::Value{ptr}}
+      __attribute__((section(".cvars." #name), used)) = {#name, {0}, console::Value{ptr}}
 
 #define CVAR_RO(name, ptr)                                                       \
   static constexpr console::Variable MACRO_PASTE(cvar_ro_, name) __attribute__(( \
-      section(".cvars"), used)) = {#name, {console::Variable::FLAG_RO}, console::Value{ptr}}
+      section(".cvars." #name), used)) = {#name, {console::Variable::FLAG_RO}, console::Value{ptr}}
 
 #define CCMD(name, n, fn)                                    \
   static constexpr console::Command MACRO_PASTE(ccmd_, name) \
-      __attribute__((section(".ccmds"), used)) = {#name, {n}, {fn}}
+      __attribute__((section(".ccmds." #name), used)) = {#name, {n}, {fn}}
+
+// Provided via linker script
+extern "C" const console::Variable __start_cvars;
+extern "C" const console::Variable __end_cvars;
+extern "C" const console::Command __start_ccmds;
+extern "C" const console::Command __end_ccmds;
 
 #define FOREACH_CVAR(x) for (auto x = &__start_cvars; x < &__end_cvars; ++x)
 
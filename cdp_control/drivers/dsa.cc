@@ -25,7 +25,9 @@
 #include <stdio.h>
 
 #include "avrx/macros.h"
+#include "avrx/progmem.h"
 #include "cdp_control.h"
+#include "cdp_debug.h"
 #include "drivers/serial_port.h"
 #include "drivers/timer.h"
 
@@ -49,10 +51,10 @@ namespace cdp {
 PROGMEM_STRINGS5(dsa_status_strings, "OK", "ERR_SYNC", "ERR_DATA", "ERR_ACK", "ERR");
 const char *to_pstring(DSA::DSA_STATUS dsa_status)
 {
-  return (PGM_P)pgm_read_word(&(dsa_status_strings[dsa_status]));
+  return avrx::pgm_read(&dsa_status_strings[dsa_status]);
 }
 
-using Timeout = Timer1::Timeout<Timer1::CHANNEL_A>;
+using Timeout = Timer1::Timeout<Timer1::CHANNEL_DSA, kDSATimeoutMS>;
 using gpio::DSA_DATA;
 using gpio::DSA_STROBE;
 using gpio::DSA_ACK;
@@ -70,7 +72,6 @@ struct ResetOnExit {
 void DSA::Init()
 {
   ResetPinState();
-  Timeout::SetMs(kDSATimeoutMS);
 }
 
 template <typename gpio>
@@ -94,6 +95,7 @@ static inline bool WaitForFallingEdge()
 DSA::ReceiveResult DSA::Receive()
 {
   ResetOnExit reset_on_exit{};
+  SetBusOp(BUS_OP_DSA_RECEIVE);
 
   Message message = INVALID_MESSAGE;
 
@@ -135,6 +137,7 @@ DSA::ReceiveResult DSA::Receive()
 DSA::DSA_STATUS DSA::Transmit(Message message)
 {
   ResetOnExit reset_on_exit{};
+  SetBusOp(BUS_OP_DSA_TRANSMIT, message);
 
   // Synchronization
   Timeout::Arm();
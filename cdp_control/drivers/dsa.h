@@ -22,7 +22,11 @@
 #ifndef DRIVERS_DSA_H_
 #define DRIVERS_DSA_H_
 
+#ifdef CDPFW_HOST
+#include <stdint.h>
+#else
 #include "drivers/gpio.h"
+#endif
 
 namespace cdp {
 
@@ -47,10 +51,16 @@ public:
     STATUS_ERR,
   };
 
+  // NOTE For host builds (CDPFW_HOST) the implementation is provided by a simulated peer instead
+  // of drivers/dsa.cc, \sa host/dsa_peer.cc
   static void Init();
 
   // Check if the other end wants to send something
+#ifdef CDPFW_HOST
+  static bool TransmitRequested();
+#else
   static inline bool TransmitRequested() { return !gpio::DSA_DATA::value(); }
+#endif
 
   // If TransmitRequested was true, try and receive something
   struct ReceiveResult {
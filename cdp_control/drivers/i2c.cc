@@ -26,13 +26,14 @@
 
 #include "avrx/avrx.h"
 #include "cdp_control.h"
+#include "cdp_debug.h"
 #include "drivers/timer.h"
 
 namespace cdp {
 
 IOREGISTER8(TWCR);
 
-using Timeout = Timer1::Timeout<Timer1::CHANNEL_B>;
+using Timeout = Timer1::Timeout<Timer1::CHANNEL_I2C, kI2CTimeoutMs>;
 
 void I2C::Init()
 {
@@ -41,12 +42,12 @@ void I2C::Init()
 
   TWCRRegister::Write<TWEN, TWINT>();
 
-  Timeout::SetMs(kI2CTimeoutMs);
   Stop();
 }
 
 bool I2C::Start(uint8_t address)
 {
+  SetBusOp(BUS_OP_I2C_START, address);
   TWCRRegister::Write<TWINT, TWSTA, TWEN>();
   Timeout::Arm();
   while (!(TWCR & _BV(TWINT))) {
@@ -135,6 +136,7 @@ uint8_t I2C::ReadNack()
 
 bool I2C::Stop()
 {
+  SetBusOp(BUS_OP_I2C_STOP);
   TWCRRegister::Write<TWEN, TWINT, TWSTO>();
   Timeout::Arm();
   while (TWCR & _BV(TWSTO)) {
@@ -23,12 +23,12 @@
 
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <string.h>
 
 #include "gpio.h"
 
 namespace cdp {
 
-// TODO We need a bulk copy for ring buffers, or a better way to queue messages
 // TODO This is inconsistent with using bits or nice wrappers
 //
 // NOTE
@@ -81,37 +81,130 @@ void SerialPort::EnableRx()
   usart0::RXCIE::set();
 }
 
-void SerialPort::Write(const char *buffer)
-{
 #ifdef ENABLE_USART_TX
-  while (*buffer) { tx_buffer_::Push(*buffer++); }
+// If interrupts are disabled (e.g. during Init) nothing will drain the queue, so we have to do it
+// ourselves.
+/*static*/ void SerialPort::WaitWritable()
+{
+  if (!(SREG & _BV(SREG_I)) && usart0::DRE::value()) Tx();
+}
+
+/*static*/ void SerialPort::Queue(TX_SOURCE source, const char *data, uint8_t length)
+{
+  while (!tx_queue_::writable()) WaitWritable();
+  auto &desc = tx_queue_::Head();
+  desc.source = source;
+  desc.length = length;
+  desc.data = data;
+  tx_queue_::Push();
   usart0::DRIE::set();
-#else
-  while (*buffer) {
-    while (!usart0::DRE::value()) { }
-    UDR0 = *buffer++;
+}
+
+void SerialPort::Write(const uint8_t *buffer, uint8_t length)
+{
+  // Copy as much as fits into the ring and queue that, then wait for more space
+  while (length) {
+    uint8_t chunk = tx_buffer_::writable();
+    if (!chunk) {
+      WaitWritable();
+      continue;
+    }
+    if (chunk > length) chunk = length;
+    length -= chunk;
+    // The ISR only consumes ring data that's been queued, so push the data first.
+    for (auto n = chunk; n; --n) tx_buffer_::Push(*buffer++);
+    Queue(TX_RING, nullptr, chunk);
   }
-#endif
+}
+
+void SerialPort::Write(const char *buffer)
+{
+  Write(reinterpret_cast<const uint8_t *>(buffer), strlen(buffer));
 }
 
 void SerialPort::WriteP(const char *buffer)
 {
-  auto c = pgm_read_byte(buffer++);
-#ifdef ENABLE_USART_TX
-  while (c) {
-    tx_buffer_::Push(c);
-    c = pgm_read_byte(buffer++);
+  auto length = strlen_P(buffer);
+  while (length) {
+    uint8_t chunk = length > 255 ? 255 : length;
+    Queue(TX_PGM, buffer, chunk);
+    buffer += chunk;
+    length -= chunk;
   }
+}
+
+void SerialPort::Write(char c)
+{
+  while (!tx_queue_::writable()) WaitWritable();
+  auto &desc = tx_queue_::Head();
+  desc.source = TX_CHAR;
+  desc.length = 1;
+  desc.c = c;
+  tx_queue_::Push();
   usart0::DRIE::set();
+}
+
+void SerialPort::Writer::Flush()
+{
+  if (pending_) Queue(TX_RING, nullptr, pending_);
+  pending_ = 0;
+}
+
+void SerialPort::Writer::Put(char c)
+{
+  // The ring can only drain what's been queued
+  if (!tx_buffer_::writable() || 0xff == pending_) Flush();
+  while (!tx_buffer_::writable()) WaitWritable();
+  tx_buffer_::Push(c);
+  ++pending_;
+}
+
+void SerialPort::Writer::PutP(const char *pstr, uint8_t length)
+{
+  Flush();
+  if (length) Queue(TX_PGM, pstr, length);
+}
+
 #else
-  while (c) {
-    while (!usart0::DRE::value()) { }
-    UDR0 = c;
-    c = pgm_read_byte(buffer++);
-  }
-#endif
+static inline void WriteByte(uint8_t c)
+{
+  while (!usart0::DRE::value()) { }
+  UDR0 = c;
 }
 
+void SerialPort::Write(const uint8_t *buffer, uint8_t length)
+{
+  while (length--) WriteByte(*buffer++);
+}
+
+void SerialPort::Write(const char *buffer)
+{
+  while (*buffer) WriteByte(*buffer++);
+}
+
+void SerialPort::WriteP(const char *buffer)
+{
+  for (auto c = pgm_read_byte(buffer); c; c = pgm_read_byte(++buffer)) WriteByte(c);
+}
+
+void SerialPort::Write(char c)
+{
+  WriteByte(c);
+}
+
+void SerialPort::Writer::Flush() {}
+
+void SerialPort::Writer::Put(char c)
+{
+  WriteByte(c);
+}
+
+void SerialPort::Writer::PutP(const char *pstr, uint8_t length)
+{
+  while (length--) WriteByte(pgm_read_byte(pstr++));
+}
+#endif
+
 void SerialPort::WriteImmediateP(const char *buffer)
 {
   auto c = pgm_read_byte(buffer++);
@@ -125,11 +218,20 @@ void SerialPort::WriteImmediateP(const char *buffer)
 #ifdef ENABLE_USART_TX
 /*static*/ void SerialPort::Tx()
 {
-  if (!tx_buffer_::empty()) {
-    UDR0 = tx_buffer_::Pop();
-  } else {
-    usart0::DRIE::set();
+  if (tx_queue_::empty()) {
+    usart0::DRIE::reset();
+    return;
+  }
+
+  auto &desc = tx_queue_::Tail();
+  char c;
+  switch (desc.source) {
+    case TX_RING: c = tx_buffer_::Pop(); break;
+    case TX_PGM: c = pgm_read_byte(desc.data++); break;
+    default: c = desc.c; break;
   }
+  UDR0 = c;
+  if (!--desc.length) tx_queue_::Skip();
 }
 #endif
 
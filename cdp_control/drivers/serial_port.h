@@ -45,27 +45,60 @@ public:
   static inline void Rx(char c) { rx_buffer_::Push(c); }
   static void Tx();
 
-  static inline uint8_t Read(char *buffer)
-  {
-    uint8_t read = 0;
-    while (rx_buffer_::readable()) {
-      *buffer++ = rx_buffer_::Pop();
-      ++read;
-    }
-    return read;
-  }
+  static inline bool readable() { return rx_buffer_::readable(); }
+  static inline char Read() { return rx_buffer_::Pop(); }
 
+  // TX is a queue of descriptors that reference the data, which is streamed by the UDRE ISR.
+  // - RAM buffers are copied into the TX ring, since they're generally re-used immediately.
+  // - PROGMEM strings are referenced in place, i.e. aren't copied.
+  // If the queue or ring are full the write waits instead of overwriting unsent data, so large
+  // outputs just take longer.
   static void Write(const char *buffer);
   static void WriteP(const char *buffer);
+  // Raw bytes, i.e. may contain 0
+  static void Write(const uint8_t *buffer, uint8_t length);
+  static void Write(char c);
+
+  // Sink for util::Format: characters are pushed into the TX ring, PROGMEM literals are referenced
+  // (i.e. zero-copy). The pending ring data is queued when needed and on destruction.
+  class Writer {
+  public:
+    ~Writer() { Flush(); }
+    void Put(char c);
+    void PutP(const char *pstr, uint8_t length);
+
+  private:
+    uint8_t pending_ = 0;
+    void Flush();
+  };
+
+  static inline util::RingBufferUsage rx_usage() { return rx_buffer_::usage(); }
+  static inline util::RingBufferUsage tx_usage() { return tx_buffer_::usage(); }
+  static inline util::RingBufferUsage tx_queue_usage() { return tx_queue_::usage(); }
 
   // Write string directly to serial without buffering/ISR. Be careful not to mix & match
   static void WriteImmediateP(const char *buffer);
 
 private:
+  enum TX_SOURCE : uint8_t { TX_RING, TX_PGM, TX_CHAR };
+
+  struct TxDescriptor {
+    TX_SOURCE source;
+    uint8_t length;
+    union {
+      const char *data;
+      char c;
+    };
+  };
+
   // These need different sizes, otherwise they clober each other.
   // That particuarly decision in avrlib did seem weird.
   using rx_buffer_ = util::RingBuffer<SerialPort, char, 64>;
   using tx_buffer_ = util::RingBuffer<SerialPort, char, 128>;
+  using tx_queue_ = util::RingBuffer<SerialPort, TxDescriptor, 8>;
+
+  static void Queue(TX_SOURCE source, const char *data, uint8_t length);
+  static void WaitWritable();
 };
 
 }  // namespace cdp
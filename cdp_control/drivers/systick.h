@@ -63,6 +63,9 @@ public:
 
   static inline uint8_t seconds() { return seconds_; }
 
+  // millis are 1/1024 s; this converts real milliseconds (e.g. datasheet delays), rounding up
+  static constexpr uint16_t MsToMillis(uint16_t ms) { return ((uint32_t)ms * 1024 + 999) / 1000; }
+
 private:
   static uint16_t ticks_;
   static volatile uint16_t millis_;
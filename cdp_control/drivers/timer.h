@@ -27,54 +27,57 @@
 
 namespace cdp {
 
-// The two channels share a common timebase; the idea is to use the same timer, but in different
-// contexts and not both channels simultaneously.
+// Timer1 runs freely and is only read, so it's also a timestamp source (e.g. for profiling) with
+// 12.8us resolution that wraps every ~839ms.
+//
+// The timeouts are "virtual" channels that just store their own deadline, so any number of them can
+// run concurrently without touching the timer. They are polled, and the deadline is compared using
+// the signed difference, so a timeout can't be longer than half the timer period (~419ms) and the
+// polling can't stop for that long either. That's fine for the busy waits in DSA/I2C.
 class Timer1 {
 public:
-
-  static constexpr uint16_t kPrescaler = 1024;
+  static constexpr uint16_t kPrescaler = 256;
 
   static void Init()
   {
-    TCCR1A = 0;
-    TCCR1B = 0;
+    TCCR1A = 0;          // Normal mode
+    TCCR1B = _BV(CS12);  // 256
     TCNT1 = 0;
-    TCCR1B |= _BV(WGM12);             // CTC Mode
-    TCCR1B |= _BV(CS12) | _BV(CS10);  // 1024
   }
 
-  enum Channel : uint8_t { CHANNEL_A = _BV(OCF1A), CHANNEL_B = _BV(OCF1B) };
+  // NOTE This is a 16-bit read via TEMP which isn't atomic wrt. other Timer1 16-bit accesses in
+  // ISRs, but there aren't any.
+  static inline uint16_t ticks() { return TCNT1; }
 
-  template <Channel channel>
-  struct Timeout {
-    static inline void SetMs(uint16_t ms) { Timer1::SetTicks<channel>(Timer1::MsToTicks(ms)); }
-    static inline void Arm()
-    {
-      TCNT1 = 0;
-      TIFR1 |= channel;
-    }
-    static inline bool timeout() { return TIFR1 & channel; }
-  };
+  static constexpr uint16_t MsToTicks(uint16_t ms)
+  {
+    return ((float)F_CPU / (float)kPrescaler / 1000.f) * ms + 0.5f;
+  }
+
+  static constexpr uint32_t TicksToUs(uint16_t ticks)
+  {
+    return (uint32_t)ticks * kPrescaler / (F_CPU / 1000000UL);
+  }
 
-  static constexpr uint16_t MsToTicks(uint16_t ms) { return ((float)F_CPU / (float)kPrescaler / 1000.f) * ms - 1; }
+  static_assert(0 == (F_CPU % 1000000UL));
 
-  template <Channel channel>
-  static inline void SetTicks(uint16_t ticks);
+  enum Channel : uint8_t { CHANNEL_DSA, CHANNEL_I2C };
 
-private:
-};
+  template <Channel channel, uint16_t timeout_ms>
+  struct Timeout {
+    static constexpr uint16_t kTicks = Timer1::MsToTicks(timeout_ms);
+    static_assert(kTicks < 0x8000, "Timeout too long for signed compare");
 
-template <>
-inline void Timer1::SetTicks<Timer1::CHANNEL_A>(uint16_t ticks)
-{
-  OCR1A = ticks;
-}
+    static inline void Arm() { deadline_ = Timer1::ticks() + kTicks; }
+    static inline bool timeout() { return static_cast<int16_t>(Timer1::ticks() - deadline_) >= 0; }
+
+  private:
+    static uint16_t deadline_;
+  };
+};
 
-template <>
-inline void Timer1::SetTicks<Timer1::CHANNEL_B>(uint16_t ticks)
-{
-  OCR1B = ticks;
-}
+template <Timer1::Channel channel, uint16_t timeout_ms>
+uint16_t Timer1::Timeout<channel, timeout_ms>::deadline_ = 0;
 
 }  // namespace cdp
 
@@ -22,8 +22,6 @@
 #include "vfd.h"
 
 #include <avr/cpufunc.h>
-#include <stdarg.h>
-#include <stdio.h>
 #include <util/delay.h>
 
 // TODO Timeout for waitbusy in init. Pullup is disabled, but...
@@ -34,8 +32,6 @@ namespace cdp {
 using namespace gpio;
 using PortD = avrx::PortD::OutputRegister;
 
-static char fmt_buffer[128];
-
 enum VFD::Command : uint8_t {
   DISPLAY_CLEAR = 0x01,
   CURSOR_HOME = 0x02,
@@ -50,6 +46,10 @@ enum VFD::Command : uint8_t {
 VFD::PowerState VFD::power_state_ = VFD::POWER_OFF;
 uint8_t VFD::lum_ = 0;
 
+uint8_t VFD::init_step_ = 0;
+VFD::PowerState VFD::init_power_state_ = VFD::POWER_OFF;
+uint8_t VFD::init_lum_ = 0;
+
 static inline ALWAYS_INLINE void SetupData()
 {
   DISP_RS::set();
@@ -104,34 +104,59 @@ template <VFD::Command command, typename... Data> inline void WriteCommandData(D
   (WriteByte(static_cast<uint8_t>(data)), ...);
 }
 
-void VFD::Init(PowerState power_state, uint8_t lum)
+// \sa https://www.nongnu.org/avr-libc/user-manual/group__util__delay.html
+//
+// So what we're doing here is borrowed from classic LCD displays to try and (soft) reset by
+// forcing 8-bit mode x3. Does it work? Maybe. Is it overkill? Probably. There still seem to be
+// some artifacts on reset though (hard to tell).
+//
+// The long delays (150ms, 10ms) are left to the caller, the 40us ones aren't worth it.
+uint8_t VFD::BeginInit(PowerState power_state, uint8_t lum)
 {
   avrx::InitPins<DISP_D4, DISP_D5, DISP_D6, DISP_D7, DISP_RS, DISP_E, DISP_BUSY>();
+  power_state_ = POWER_OFF;
+  init_power_state_ = power_state;
+  init_lum_ = lum;
+  init_step_ = 1;
+  return 150;
+}
+
+uint8_t VFD::InitStep()
+{
+  switch (init_step_) {
+    case 1:
+      SetupCommand();
+      WriteNibble(SELECT_8BIT);
+      init_step_ = 2;
+      return 10;
+    case 2:
+      WriteNibble(SELECT_8BIT);
+      _delay_ms(0.04);
+      WriteNibble(SELECT_8BIT);
+      _delay_ms(0.04);
+      WriteNibble(SELECT_4BIT);
+      _delay_ms(0.04);
+      WriteCommandData<SELECT_4BIT>(0x3);  // minimum
+      _delay_ms(0.04);
+      // According to datasheet:
+      // "Do not read the status immediately after this command, a delay of 40us should be used
+      // instead."
+
+      Clear();
+      SetLum(init_lum_);
+      SetPowerState(init_power_state_);
+      break;
+    default: break;
+  }
+  init_step_ = 0;
+  return 0;
+}
 
-  // \sa https://www.nongnu.org/avr-libc/user-manual/group__util__delay.html
-
-  // So what we're doing here is borrowed from classic LCD displays to try and (soft) reset by
-  // forcing 8-bit mode x3. Does it work? Maybe. Is it overkill? Probably. There still seem to be
-  // some artifacts on reset though (hard to tell).
-  _delay_ms(150);
-  SetupCommand();
-  WriteNibble(SELECT_8BIT);
-  _delay_ms(10);
-  WriteNibble(SELECT_8BIT);
-  _delay_ms(0.04);
-  WriteNibble(SELECT_8BIT);
-  _delay_ms(0.04);
-  WriteNibble(SELECT_4BIT);
-  _delay_ms(0.04);
-  WriteCommandData<SELECT_4BIT>(0x3);  // minimum
-  _delay_ms(0.04);
-  // According to datasheet:
-  // "Do not read the status immediately after this command, a delay of 40us should be used
-  // instead."
-
-  Clear();
-  SetLum(lum);
-  SetPowerState(power_state);
+void VFD::Init(PowerState power_state, uint8_t lum)
+{
+  for (auto ms = BeginInit(power_state, lum); ms; ms = InitStep()) {
+    while (ms--) _delay_ms(1);
+  }
 }
 
 void VFD::Clear()
@@ -192,7 +217,6 @@ void VFD::SetRect(uint16_t x1, uint8_t y1, uint16_t x2, uint8_t y2, char cmd)
   WriteCommandData<WRITE_GRAPHIC_IMAGE>(x1 >> 8, x1, y1, x2 >> 8, x2, y2, cmd);
 }
 
-#if 0
 void VFD::Print(const char *str)
 {
   SetupData();
@@ -212,28 +236,20 @@ void VFD::PrintP(const char *str)
     c = pgm_read_byte(str++);
   }
 }
-#endif
 
-void VFD::Printf(const char *fmt, ...)
+VFD::Writer::Writer()
 {
   SetupData();
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(fmt_buffer, sizeof(fmt_buffer), fmt, args);
-  va_end(args);
-  auto str = fmt_buffer;
-  while (*str) WriteByte(*str++);
 }
 
-void VFD::PrintfP(const char *fmt, ...)
+void VFD::Writer::Put(char c)
 {
-  SetupData();
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf_P(fmt_buffer, sizeof(fmt_buffer), fmt, args);
-  va_end(args);
-  auto str = fmt_buffer;
-  while (*str) WriteByte(*str++);
+  WriteByte(c);
+}
+
+void VFD::Writer::PutP(const char *pstr, uint8_t length)
+{
+  while (length--) WriteByte(pgm_read_byte(pstr++));
 }
 
 }  // namespace cdp
@@ -26,6 +26,7 @@
 
 #include "avrx/avrx.h"
 #include "gpio.h"
+#include "util/format.h"
 #include "util/utils.h"
 
 namespace cdp {
@@ -53,6 +54,11 @@ public:
 
   enum Command : uint8_t;
 
+  // The reset sequence is mostly waiting, so it's split into steps that don't block. BeginInit
+  // starts it; InitStep should be called once the returned number of milliseconds have passed,
+  // until it returns 0 and the display is ready. Init does the same thing but blocks.
+  static uint8_t BeginInit(PowerState power_state, uint8_t lum);
+  static uint8_t InitStep();
   static void Init(PowerState power_state, uint8_t lum);
 
   static void Clear();
@@ -61,12 +67,22 @@ public:
   static void SetFont(Font font);
 
   static void SetCursor(uint8_t line, uint8_t col);
-#if 0
   static void PrintP(const char *pstr);
   static void Print(const char *str);
-#endif
-  static void Printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
-  static void PrintfP(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+  // Sink for util::Format that writes directly to the display
+  struct Writer {
+    Writer();
+    void Put(char c);
+    void PutP(const char *pstr, uint8_t length);
+  };
+
+  template <typename Fmt, typename... Args>
+  static util::if_format_t<Fmt> Print(Fmt fmt, Args... args)
+  {
+    Writer writer;
+    util::Format(writer, fmt, args...);
+  }
 
   static void SetGraphicCursor(uint16_t x, uint8_t y);
   static void WriteIcon16x16P(uint16_t x, uint8_t y, const uint8_t *data);
@@ -76,9 +92,12 @@ public:
   static inline bool powered() { return power_state_; }
 
 private:
-
   static PowerState power_state_;
   static uint8_t lum_;
+
+  static uint8_t init_step_;
+  static PowerState init_power_state_;
+  static uint8_t init_lum_;
 };
 
 }  // namespace cdp
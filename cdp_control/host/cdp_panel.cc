@@ -0,0 +1,422 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+// Virtual front panel: runs the menus and drivers/vfd.cc against the emulated display (\sa
+// vfd_emulator.h) through a set of scripted scenarios and reports the number of bytes sent to the
+// display per frame (i.e. per Menus::Draw). Optionally writes the final frame of each scenario as
+// image, which can be used as golden image, or all frames that changed.
+//
+// Usage: cdp_panel [-o dir] [-a] [-c dir] [-p] [-s scale] [-v] [scenario...]
+//   -o dir    Write <dir>/<scenario>.png (or .ppm with -p)
+//   -a        Also write every changed frame as <dir>/<scenario>_<frame>.png
+//   -c dir    Compare final frames against the images in dir
+//   -s scale  Pixel scale of images (default 4)
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cdp_control.h"
+#include "cdp_debug.h"
+#include "cdpro2.h"
+#include "drivers/systick.h"
+#include "dsa_peer.h"
+#include "menus.h"
+#include "serial_console.h"
+#include "settings.h"
+#include "timer_slots.h"
+#include "ui/ui.h"
+#include "vfd_emulator.h"
+
+namespace cdp {
+
+// Things usually provided by cdp_control.cc & friends
+GlobalState global_state;
+DebugInfo debug_info;
+
+/*static*/ uint16_t SysTick::ticks_ = 0;
+/*static*/ volatile uint16_t SysTick::millis_ = 0;
+/*static*/ volatile uint8_t SysTick::seconds_ = 0;
+
+static bool verbose = false;
+
+// SerialConsole::Print output is collected and printed per line
+static char console_line[256];
+static size_t console_length = 0;
+
+void SerialPort::Writer::Put(char c)
+{
+  if ('\r' != c && '\n' != c && console_length < sizeof(console_line) - 1)
+    console_line[console_length++] = c;
+}
+
+void SerialPort::Writer::PutP(const char *pstr, uint8_t length)
+{
+  while (length--) Put(pgm_read_byte(pstr++));
+}
+
+void SerialPort::Writer::Flush()
+{
+  console_line[console_length] = 0;
+  if (verbose) printf("    %s\n", console_line);
+  console_length = 0;
+}
+
+// Subscribers (\sa topics.h) that would talk to the hardware
+void ApplyInput(int8_t input)
+{
+  global_state.src4392.source = input ? SOURCE_DIR : SOURCE_I2S;
+}
+
+void ApplyMute(bool mute)
+{
+  ui::UI::set_led(ui::UI::LED_MUTE, mute);
+}
+
+void ApplyBrightness(uint8_t)
+{
+  global_state.restore_brightness();
+}
+
+/*static*/ void SRC4392::SelectReceiver(int8_t) {}
+/*static*/ void SRC4392::SelectFilter(int8_t) {}
+/*static*/ void SRC4392::SelectOutput(int8_t) {}
+
+PROGMEM const char boot_msg[] = "CDPFW " CDPFW_VERSION_STRING;
+
+namespace host {
+
+struct Options {
+  const char *output_dir = nullptr;
+  const char *compare_dir = nullptr;
+  bool all_frames = false;
+  bool ppm = false;
+  uint8_t scale = 4;
+};
+static Options options;
+
+struct FrameStats {
+  uint32_t frames = 0;
+  uint32_t empty = 0;  // Frames that didn't send anything
+  uint32_t bytes = 0;
+  uint32_t max = 0;
+  uint32_t init = 0;  // Bytes before the first frame
+};
+static FrameStats frame_stats;
+static uint32_t last_checksum = 0;
+
+static const char *current_scenario = "";
+static uint32_t sim_millis = 0;
+static uint16_t last_tick_millis = 0;
+static uint16_t last_draw_millis = 0;
+
+static bool WriteImage(const char *dir, const char *name)
+{
+  char filename[256];
+  snprintf(filename, sizeof(filename), "%s/%s.%s", dir, name, options.ppm ? "ppm" : "png");
+  return options.ppm ? VfdEmulator::WritePPM(filename, options.scale)
+                     : VfdEmulator::WritePNG(filename, options.scale);
+}
+
+static bool SameFile(const char *a, const char *b)
+{
+  auto fa = fopen(a, "rb");
+  auto fb = fopen(b, "rb");
+  bool same = fa && fb;
+  while (same) {
+    int ca = fgetc(fa);
+    same = ca == fgetc(fb);
+    if (EOF == ca) break;
+  }
+  if (fa) fclose(fa);
+  if (fb) fclose(fb);
+  return same;
+}
+
+static void Frame()
+{
+  Menus::Draw();
+
+  auto bytes = VfdEmulator::EndFrame();
+  ++frame_stats.frames;
+  frame_stats.bytes += bytes;
+  if (bytes > frame_stats.max) frame_stats.max = bytes;
+  if (!bytes) ++frame_stats.empty;
+
+  auto checksum = VfdEmulator::checksum();
+  if (options.all_frames && options.output_dir && checksum != last_checksum) {
+    char name[128];
+    snprintf(name, sizeof(name), "%s_%05u", current_scenario, (unsigned)frame_stats.frames);
+    WriteImage(options.output_dir, name);
+  }
+  last_checksum = checksum;
+}
+
+// One pass of the main loop per SysTick milli, following cdp_control.cc (minus the hardware)
+static void Step()
+{
+  for (uint8_t i = 0; i < F_INTERRUPTS / 1024; ++i) SysTick::Tick();
+  ++sim_millis;
+
+  auto millis = SysTick::millis();
+  TimerSlots::Tick(millis);
+  DsaPeer::Tick(sim_millis);
+
+  auto elapsed_millis = millis - last_tick_millis;
+  last_tick_millis = millis;
+  CDPlayer::Tick(elapsed_millis);
+  Menus::Tick(elapsed_millis);
+
+  if (VFD::powered()) {
+    if (global_state.disp_brightness.dirty()) {
+      VFD::SetLum(global_state.disp_brightness);
+      global_state.disp_brightness.clear();
+    }
+    if (millis - last_draw_millis > kRedrawMs) {
+      Frame();
+      last_draw_millis = millis;
+    }
+  }
+
+  global_state.lid_open.clear();
+  global_state.src4392.clear_dirty();
+}
+
+static void Run(uint32_t millis)
+{
+  while (millis--) Step();
+}
+
+static void Event(uint8_t id, int8_t value)
+{
+  Menus::HandleEvent(ui::Event{ui::EVENT_ENCODER, id, value});
+}
+
+static void Press(uint8_t id)
+{
+  Event(id, 1);
+  Run(50);
+  Event(id, 0);
+}
+
+// Same as cdp_control.cc Init/main, except the hardware that isn't emulated
+static void Boot()
+{
+  VfdEmulator::Reset();
+  global_state.lid_open = false;
+  global_state.src4392.ratio = 0x03ac;  // 44.1KHz
+
+  VFD::Init(VFD::POWER_OFF, global_state.disp_brightness);
+  VFD::PrintP(boot_msg);
+  VFD::SetPowerState(VFD::POWER_ON);
+
+  DsaPeer::Reset(DsaPeer::Config{});
+  CDPlayer::Init();
+  Settings::PublishAll();
+  global_state.src4392.mute.publish();
+  global_state.src4392.force_dirty();
+
+  frame_stats.init = VfdEmulator::EndFrame();
+}
+
+static void SkipSplash()
+{
+  Menus::Init();
+  Run(2500);
+}
+
+// Scenarios
+
+static void BootMessage()
+{
+  Boot();
+}
+
+static void Splash()
+{
+  Boot();
+  Menus::Init();
+  Run(1000);
+}
+
+static void MainIdle()
+{
+  Boot();
+  SkipSplash();
+  Run(5000);  // Overlays time out
+}
+
+static void Play()
+{
+  Boot();
+  SkipSplash();
+  CDPlayer::TogglePower();
+  Run(8000);
+}
+
+static void Volume()
+{
+  Boot();
+  SkipSplash();
+  global_state.src4392.mute = false;
+  global_state.src4392.attenuation = 40;
+  Run(3000);
+  for (int i = 0; i < 20; ++i) {
+    Event(ui::UI::CONTROL_ENC, 1);
+    Run(30);
+  }
+}
+
+static void Mute()
+{
+  Boot();
+  SkipSplash();
+  global_state.src4392.mute = false;
+  Run(3000);
+  Press(ui::UI::CONTROL_SW_ENC);
+  Run(200);
+}
+
+static void SettingsMenu()
+{
+  Boot();
+  SkipSplash();
+  Press(ui::UI::CONTROL_SW_MENU);
+  Run(200);
+  Event(ui::UI::CONTROL_ENC, 1);
+  Run(200);
+  Press(ui::UI::CONTROL_SW_ENC);
+  Run(200);
+}
+
+static void DebugMenu()
+{
+  Boot();
+  SkipSplash();
+  Menus::set_current(&menu_debug);
+  Run(500);
+}
+
+struct Scenario {
+  const char *name;
+  void (*fn)();
+};
+
+static const Scenario kScenarios[] = {
+    {"boot", BootMessage}, {"splash", Splash}, {"main_idle", MainIdle},
+    {"play", Play},        {"volume", Volume}, {"mute", Mute},
+    {"settings", SettingsMenu}, {"debug", DebugMenu},
+};
+
+static bool RunScenario(const Scenario &scenario)
+{
+  current_scenario = scenario.name;
+  scenario.fn();
+
+  bool result = !VfdEmulator::stats().unknown;
+  const char *compare = "";
+  if (options.output_dir) result &= WriteImage(options.output_dir, scenario.name);
+  if (options.compare_dir) {
+    // The output is deterministic so this just compares the files
+    char name[64];
+    snprintf(name, sizeof(name), "cdp_panel_%d", (int)getpid());
+    WriteImage("/tmp", name);
+    char actual[128], expected[256];
+    snprintf(actual, sizeof(actual), "/tmp/%s.%s", name, options.ppm ? "ppm" : "png");
+    snprintf(expected, sizeof(expected), "%s/%s.%s", options.compare_dir, scenario.name,
+             options.ppm ? "ppm" : "png");
+    bool same = SameFile(actual, expected);
+    remove(actual);
+    compare = same ? "SAME" : "DIFF";
+    result &= same;
+  }
+
+  auto &stats = VfdEmulator::stats();
+  printf("%-10s %-4s %7u %6u %6u %6u %8u %6.1f %6u %s\n", scenario.name, result ? "OK" : "FAIL",
+         (unsigned)sim_millis, (unsigned)frame_stats.init, (unsigned)frame_stats.frames,
+         (unsigned)frame_stats.empty, (unsigned)stats.bytes,
+         frame_stats.frames ? (double)frame_stats.bytes / frame_stats.frames : 0.0,
+         (unsigned)frame_stats.max, compare);
+  return result;
+}
+
+}  // namespace host
+}  // namespace cdp
+
+// The IR receiver isn't emulated
+uint_fast8_t irmp_ISR()
+{
+  return 0;
+}
+
+uint_fast8_t irmp_get_data(IRMP_DATA *)
+{
+  return 0;
+}
+
+using namespace cdp::host;
+
+int main(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "o:ac:ps:v")) != -1) {
+    switch (opt) {
+      case 'o': options.output_dir = optarg; break;
+      case 'a': options.all_frames = true; break;
+      case 'c': options.compare_dir = optarg; break;
+      case 'p': options.ppm = true; break;
+      case 's': options.scale = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+      case 'v': cdp::verbose = true; break;
+      default:
+        fprintf(stderr, "Usage: %s [-o dir] [-a] [-c dir] [-p] [-s scale] [-v] [scenario...]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  printf("%-10s %-4s %7s %6s %6s %6s %8s %6s %6s\n", "SCENARIO", "", "MS", "INIT", "FRAMES",
+         "EMPTY", "BYTES", "B/FRM", "MAX");
+
+  unsigned failed = 0;
+  unsigned run = 0;
+  for (const auto &scenario : kScenarios) {
+    if (optind < argc) {
+      bool selected = false;
+      for (int i = optind; i < argc; ++i) selected |= !strcmp(argv[i], scenario.name);
+      if (!selected) continue;
+    }
+
+    fflush(stdout);
+    auto pid = fork();
+    if (!pid) exit(RunScenario(scenario) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status)) ++failed;
+    ++run;
+  }
+
+  printf("%u/%u scenarios OK\n", run - failed, run);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,341 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Runs cdpro2.cc against the simulated DSA peer (\sa dsa_peer.h) through a set of scripted
+// scenarios, as fast as the host allows. Each scenario runs in its own process so it starts from
+// the same (static) state as the firmware after reset.
+//
+// Usage: cdp_sim [-v] [scenario...]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cdp_control.h"
+#include "cdpro2.h"
+#include "drivers/systick.h"
+#include "dsa_peer.h"
+#include "serial_console.h"
+#include "timer_slots.h"
+
+namespace cdp {
+
+// Things usually provided by cdp_control.cc & friends
+GlobalState global_state;
+
+/*static*/ uint16_t SysTick::ticks_ = 0;
+/*static*/ volatile uint16_t SysTick::millis_ = 0;
+/*static*/ volatile uint8_t SysTick::seconds_ = 0;
+
+static bool verbose = false;
+
+// SerialConsole::Print output is collected and printed per line
+static char console_line[256];
+static size_t console_length = 0;
+
+void SerialPort::Writer::Put(char c)
+{
+  if ('\r' != c && '\n' != c && console_length < sizeof(console_line) - 1)
+    console_line[console_length++] = c;
+}
+
+void SerialPort::Writer::PutP(const char *pstr, uint8_t length)
+{
+  while (length--) Put(pgm_read_byte(pstr++));
+}
+
+void SerialPort::Writer::Flush()
+{
+  console_line[console_length] = 0;
+  if (verbose) printf("    %s\n", console_line);
+  console_length = 0;
+}
+
+namespace host {
+
+static uint32_t sim_millis = 0;
+static uint16_t last_tick_millis = 0;
+
+// One pass of the main loop per SysTick milli, in the same order as cdp_control.cc
+static void Step()
+{
+  for (uint8_t i = 0; i < F_INTERRUPTS / 1024; ++i) SysTick::Tick();
+  ++sim_millis;
+
+  auto millis = SysTick::millis();
+  TimerSlots::Tick(millis);
+  DsaPeer::Tick(sim_millis);
+
+  CDPlayer::Tick(millis - last_tick_millis);
+  last_tick_millis = millis;
+
+  global_state.lid_open.clear();
+}
+
+static void Run(uint32_t millis)
+{
+  while (millis--) Step();
+}
+
+static bool RunUntil(bool (*condition)(), uint32_t timeout)
+{
+  while (timeout--) {
+    Step();
+    if (condition()) return true;
+  }
+  return false;
+}
+
+static const char *status()
+{
+  static char buffer[64];
+  CDPlayer::GetStatus(buffer);
+  return buffer;
+}
+
+static bool playing()
+{
+  return 'P' == status()[3] && DsaPeer::playing();
+}
+
+static bool powered_off()
+{
+  return !CDPlayer::powered() && !strcmp(status(), " OFF");
+}
+
+static bool no_disc()
+{
+  return strstr(status(), "NO DISC");
+}
+
+static constexpr uint32_t kTimeout = 10 * 1024;
+
+// Scenarios
+// Each sets up the peer, and returns true if the player ended up where expected.
+
+static bool PowerOnPlay(DsaPeer::Config &config)
+{
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  return RunUntil(playing, kTimeout) && config.min_track == DsaPeer::title();
+}
+
+static bool PowerOnPlayTitle(DsaPeer::Config &config)
+{
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  Run(100);
+  CDPlayer::PlayTitle(5);
+  return RunUntil(playing, kTimeout) && 5 == DsaPeer::title();
+}
+
+static bool NoDisc(DsaPeer::Config &config)
+{
+  config.disc = false;
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  return RunUntil(no_disc, kTimeout);
+}
+
+static bool LidOpenDuringTOC(DsaPeer::Config &config)
+{
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil([] { return DsaPeer::received(CDPro2::READ_TOC); }, kTimeout)) return false;
+  Run(config.toc_ms / 2);
+
+  global_state.lid_open = true;
+  Run(500);
+  if (DsaPeer::playing()) return false;
+
+  global_state.lid_open = false;
+  return RunUntil(playing, kTimeout);
+}
+
+static bool PowerToggleMidCommand(DsaPeer::Config &config)
+{
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil([] { return DsaPeer::received(CDPro2::SPIN_UP); }, kTimeout)) return false;
+  Run(config.spin_up_ms / 2);
+
+  CDPlayer::TogglePower();
+  if (!RunUntil(powered_off, kTimeout)) return false;
+
+  CDPlayer::TogglePower();
+  return RunUntil(playing, kTimeout);
+}
+
+static bool TransmitError(DsaPeer::Config &config)
+{
+  // Nothing in the firmware retries yet, so this needs a user to stop & play again
+  config.fail_opcode = CDPro2::PLAY_TITLE;
+  config.fail_count = 1;
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil([] { return DsaPeer::received(CDPro2::PLAY_TITLE); }, kTimeout)) return false;
+  if (RunUntil(playing, 2 * 1024)) return false;
+
+  CDPlayer::Stop();
+  Run(500);
+  CDPlayer::Play();
+  return RunUntil(playing, kTimeout);
+}
+
+static bool Resume(DsaPeer::Config &config)
+{
+  static constexpr uint32_t kPlayMillis = 20 * 1024;
+
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil(playing, kTimeout)) return false;
+  Run(kPlayMillis);
+
+  CDPlayer::TogglePower();
+  if (!RunUntil(powered_off, kTimeout)) return false;
+
+  CDPlayer::TogglePower();
+  return RunUntil(playing, kTimeout) && DsaPeer::received(CDPro2::GOTO_TIME_FRAMES) &&
+         DsaPeer::position() >= kPlayMillis * CDPro2::MSF::kFramesPerSecond / 1024;
+}
+
+static bool Scan(DsaPeer::Config &config)
+{
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil(playing, kTimeout)) return false;
+  Run(2 * config.report_ms);  // ABSOLUTE_TIME_*
+
+  // Hold for 4s at RC5 repeat rate
+  auto start = DsaPeer::position();
+  for (int i = 0; i < 35; ++i) {
+    CDPlayer::Scan(1);
+    Run(114);
+  }
+  return RunUntil(playing, kTimeout) &&
+         DsaPeer::position() > start + 30 * CDPro2::MSF::kFramesPerSecond;
+}
+
+static bool ScanWhileBusy(DsaPeer::Config &config)
+{
+  static constexpr uint32_t kPlayMillis = 30 * 1024;
+
+  DsaPeer::Reset(config);
+  CDPlayer::TogglePower();
+  if (!RunUntil(playing, kTimeout)) return false;
+  Run(kPlayMillis);
+
+  // A SET_MODE is still waiting for its response when the key is pressed, so the scan has to start
+  // from the current position rather than wherever the last one ended (nowhere, i.e. 0:00).
+  CDPlayer::SetMode(0);
+  if (!RunUntil([] { return DsaPeer::received(CDPro2::SET_MODE); }, kTimeout)) return false;
+  auto start = DsaPeer::position();
+  for (int i = 0; i < 4; ++i) {
+    CDPlayer::Scan(-1);
+    Run(114);
+  }
+  return RunUntil(playing, kTimeout) && DsaPeer::received(CDPro2::GOTO_TIME_FRAMES) &&
+         DsaPeer::position() + 10 * CDPro2::MSF::kFramesPerSecond > start;
+}
+
+struct Scenario {
+  const char *name;
+  bool (*fn)(DsaPeer::Config &);
+};
+
+static const Scenario kScenarios[] = {
+    {"power_on_play", PowerOnPlay},
+    {"power_on_title", PowerOnPlayTitle},
+    {"no_disc", NoDisc},
+    {"lid_open_toc", LidOpenDuringTOC},
+    {"power_toggle", PowerToggleMidCommand},
+    {"tx_error", TransmitError},
+    {"resume", Resume},
+    {"scan", Scan},
+    {"scan_busy", ScanWhileBusy},
+};
+
+static double wall_seconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool RunScenario(const Scenario &scenario)
+{
+  DsaPeer::Config config;
+  auto start = wall_seconds();
+  bool result = scenario.fn(config);
+  auto elapsed = wall_seconds() - start;
+
+  auto &stats = DsaPeer::stats();
+  printf("%-16s %-4s %7u %5u %4u %4u %6u %6u %8.0fx\n", scenario.name, result ? "OK" : "FAIL",
+         (unsigned)sim_millis, stats.commands, stats.retries, stats.tx_errors,
+         stats.completed ? (unsigned)(stats.latency_total / stats.completed) : 0,
+         (unsigned)stats.latency_max, sim_millis / 1024.0 / elapsed);
+  CDPlayer::PrintStartupTimes();
+  return result;
+}
+
+}  // namespace host
+}  // namespace cdp
+
+using namespace cdp::host;
+
+int main(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "v")) != -1) {
+    switch (opt) {
+      case 'v': cdp::verbose = true; break;
+      default: fprintf(stderr, "Usage: %s [-v] [scenario...]\n", argv[0]); return EXIT_FAILURE;
+    }
+  }
+
+  printf("%-16s %-4s %7s %5s %4s %4s %6s %6s %9s\n", "SCENARIO", "", "MS", "CMDS", "RTRY", "ERRS",
+         "LATAVG", "LATMAX", "SPEED");
+
+  unsigned failed = 0;
+  unsigned run = 0;
+  for (const auto &scenario : kScenarios) {
+    if (optind < argc) {
+      bool selected = false;
+      for (int i = optind; i < argc; ++i) selected |= !strcmp(argv[i], scenario.name);
+      if (!selected) continue;
+    }
+
+    fflush(stdout);
+    auto pid = fork();
+    if (!pid) exit(RunScenario(scenario) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status)) ++failed;
+    ++run;
+  }
+
+  printf("%u/%u scenarios OK\n", run - failed, run);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,375 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "dsa_peer.h"
+
+#include <string.h>
+
+#include "avrx/macros.h"
+#include "avrx/progmem.h"
+#include "cdpro2.h"
+#include "drivers/relays.h"
+
+namespace cdp {
+namespace host {
+
+/*static*/ DsaPeer::Config DsaPeer::config_;
+/*static*/ DsaPeer::Stats DsaPeer::stats_;
+/*static*/ uint32_t DsaPeer::now_ = 0;
+/*static*/ bool DsaPeer::powered_ = false;
+/*static*/ bool DsaPeer::ready_ = false;
+/*static*/ uint32_t DsaPeer::ready_at_ = 0;
+/*static*/ bool DsaPeer::received_[256] = {false};
+/*static*/ bool DsaPeer::spun_ = false;
+/*static*/ bool DsaPeer::toc_read_ = false;
+/*static*/ bool DsaPeer::playing_ = false;
+/*static*/ bool DsaPeer::paused_ = false;
+/*static*/ uint8_t DsaPeer::title_ = 0;
+/*static*/ uint32_t DsaPeer::start_frames_ = 0;
+/*static*/ uint32_t DsaPeer::start_millis_ = 0;
+/*static*/ uint32_t DsaPeer::next_report_ = 0;
+/*static*/ uint8_t DsaPeer::goto_time_[2] = {0, 0};
+/*static*/ DSA::Message DsaPeer::command_ = DSA::INVALID_MESSAGE;
+/*static*/ uint32_t DsaPeer::command_millis_ = 0;
+/*static*/ bool DsaPeer::command_completed_ = true;
+/*static*/ DSA::Message DsaPeer::unanswered_ = DSA::INVALID_MESSAGE;
+/*static*/ DsaPeer::Scheduled DsaPeer::scheduled_;
+/*static*/ DsaPeer::Outgoing DsaPeer::tx_[DsaPeer::kMaxOutgoing];
+/*static*/ uint8_t DsaPeer::tx_head_ = 0;
+/*static*/ uint8_t DsaPeer::tx_tail_ = 0;
+
+// NOTE This deliberately doesn't use CDPro2::MSF's functions so the peer can be linked without
+// cdpro2.cc (\sa bench/cdp_bench.cc)
+static constexpr uint32_t kFramesPerSecond = CDPro2::MSF::kFramesPerSecond;
+
+static inline uint32_t to_frames(uint8_t minutes, uint8_t seconds, uint8_t frames)
+{
+  return ((uint32_t)minutes * 60 + seconds) * kFramesPerSecond + frames;
+}
+
+// Pretend there's a 2s pregap and all titles have the same length
+static constexpr uint32_t kPregapFrames = 2 * kFramesPerSecond;
+
+void DsaPeer::Reset(const Config &config)
+{
+  config_ = config;
+  stats_ = {};
+  now_ = 0;
+  memset(received_, 0, sizeof(received_));
+  PowerOff();
+}
+
+void DsaPeer::PowerOff()
+{
+  powered_ = ready_ = false;
+  spun_ = toc_read_ = playing_ = paused_ = false;
+  title_ = 0;
+  start_frames_ = 0;
+  scheduled_ = {};
+  command_ = DSA::INVALID_MESSAGE;
+  command_completed_ = true;
+  unanswered_ = DSA::INVALID_MESSAGE;
+  tx_head_ = tx_tail_ = 0;
+}
+
+void DsaPeer::Tick(uint32_t now)
+{
+  now_ = now;
+
+  static constexpr uint8_t kPowerMask = Relays::AUX_AC | Relays::AUX_9V;
+  bool powered = kPowerMask == (Relays::output_state() & kPowerMask);
+  if (powered != powered_) {
+    if (powered) {
+      powered_ = true;
+      ready_at_ = now + config_.boot_ms;
+    } else {
+      PowerOff();
+    }
+  }
+  if (!powered_) return;
+  if (!ready_ && now >= ready_at_) ready_ = true;
+
+  if (scheduled_.valid && now >= scheduled_.due) {
+    scheduled_.valid = false;
+    Execute(scheduled_.opcode, scheduled_.param);
+  }
+
+  if (playing()) {
+    auto frames = position();
+    if (frames >= lead_out()) {
+      start_frames_ = lead_out();
+      playing_ = false;
+      Send(CDPro2::STOPPED, 0);
+    } else if (now >= next_report_) {
+      next_report_ += config_.report_ms;
+      auto title = title_at(frames);
+      SendPosition(title != title_);
+      title_ = title;
+    }
+  }
+}
+
+uint32_t DsaPeer::position()
+{
+  if (!playing()) return start_frames_;
+  return start_frames_ + (now_ - start_millis_) * kFramesPerSecond / 1024;
+}
+
+DSA::ReceiveResult DsaPeer::Receive()
+{
+  if (!transmit_requested()) return {DSA::STATUS_ERR_SYNC, DSA::INVALID_MESSAGE};
+
+  auto outgoing = tx_[tx_tail_];
+  tx_tail_ = (tx_tail_ + 1) % kMaxOutgoing;
+  ++stats_.responses;
+  if (outgoing.completes && !command_completed_) {
+    command_completed_ = true;
+    auto latency = now_ - command_millis_;
+    ++stats_.completed;
+    stats_.latency_total += latency;
+    if (latency > stats_.latency_max) stats_.latency_max = latency;
+  }
+  return {DSA::STATUS_OK, outgoing.message};
+}
+
+DSA::DSA_STATUS DsaPeer::Transmit(DSA::Message message)
+{
+  if (!ready_) {
+    ++stats_.tx_errors;
+    return DSA::STATUS_ERR_SYNC;
+  }
+
+  auto opcode = DSA::UnpackOpcode(message);
+  auto param = DSA::UnpackData(message);
+  received_[opcode] = true;
+
+  // The goto time is set up over several messages, but only the last one is a command
+  if (CDPro2::GOTO_TIME_MINUTES == opcode || CDPro2::GOTO_TIME_SECONDS == opcode) {
+    goto_time_[opcode - CDPro2::GOTO_TIME_MINUTES] = param;
+    return DSA::STATUS_OK;
+  }
+
+  ++stats_.commands;
+  if (!command_completed_) unanswered_ = command_;
+  if (message == unanswered_) {
+    ++stats_.retries;
+    unanswered_ = DSA::INVALID_MESSAGE;
+  }
+  command_ = message;
+  command_millis_ = now_;
+  command_completed_ = false;
+
+  if (opcode == config_.fail_opcode && config_.fail_count) {
+    --config_.fail_count;
+    ++stats_.tx_errors;
+    return DSA::STATUS_ERR_ACK;
+  }
+
+  uint16_t delay = config_.response_ms;
+  switch (opcode) {
+    case CDPro2::SPIN_UP: delay = spun_ ? config_.response_ms : config_.spin_up_ms; break;
+    case CDPro2::READ_TOC:
+      delay = config_.toc_ms + (spun_ || !config_.disc ? 0 : config_.spin_up_ms);
+      break;
+    case CDPro2::PLAY_TITLE:
+    case CDPro2::GOTO_TIME_FRAMES: delay = config_.seek_ms; break;
+    case CDPro2::STOP: delay = config_.stop_ms; break;
+    default: break;
+  }
+  Schedule(opcode, param, delay);
+  return DSA::STATUS_OK;
+}
+
+void DsaPeer::Schedule(uint8_t opcode, uint8_t param, uint16_t delay)
+{
+  scheduled_.due = now_ + delay;
+  scheduled_.opcode = opcode;
+  scheduled_.param = param;
+  scheduled_.valid = true;
+}
+
+void DsaPeer::Execute(uint8_t opcode, uint8_t param)
+{
+  switch (opcode) {
+    case CDPro2::SPIN_UP:
+      if (!config_.disc) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::NO_DISC, true);
+      } else {
+        spun_ = true;
+        Send(CDPro2::FOUND, 0x43, true);
+      }
+      break;
+
+    case CDPro2::READ_TOC:
+      if (!config_.disc) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::NO_DISC, true);
+      } else {
+        // Afterwards the drive is paused at the start of the first title
+        spun_ = toc_read_ = true;
+        playing_ = paused_ = false;
+        start_frames_ = kPregapFrames;
+        Send(CDPro2::TOC_MIN_TRACK_NUMBER, config_.min_track);
+        Send(CDPro2::TOC_MAX_TRACK_NUMBER, config_.max_track);
+        Send(CDPro2::TOC_TIME_MINUTES, config_.disc_time[0]);
+        Send(CDPro2::TOC_TIME_SECONDS, config_.disc_time[1]);
+        Send(CDPro2::TOC_TIME_FRAMES, config_.disc_time[2], true);
+      }
+      break;
+
+    case CDPro2::PLAY_TITLE:
+      if (!toc_read_) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::TOC_ERROR, true);
+      } else if (param < config_.min_track || param > config_.max_track) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::ILLEGAL_VALUE, true);
+      } else {
+        StartPlay(title_start(param));
+        Send(CDPro2::FOUND, 0, true);
+      }
+      break;
+
+    case CDPro2::GOTO_TIME_FRAMES: {
+      auto frames = to_frames(goto_time_[0], goto_time_[1], param);
+      if (!toc_read_) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::TOC_ERROR, true);
+      } else if (frames < kPregapFrames || frames >= lead_out()) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::ILLEGAL_TIME_VALUE, true);
+      } else {
+        StartPlay(frames);
+        Send(CDPro2::FOUND, 0x40, true);
+      }
+    } break;
+
+    case CDPro2::STOP:
+      start_frames_ = position();
+      playing_ = paused_ = false;
+      Send(CDPro2::STOPPED, 0, true);
+      break;
+
+    case CDPro2::PAUSE:
+      if (!playing_) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::ILLEGAL_COMMAND, true);
+      } else {
+        start_frames_ = position();
+        paused_ = true;
+        Send(CDPro2::FOUND, 0x41, true);
+      }
+      break;
+
+    case CDPro2::PAUSE_RELEASE:
+      if (!playing_) {
+        Send(CDPro2::ERROR_VALUES, CDPro2::ILLEGAL_COMMAND, true);
+      } else {
+        paused_ = false;
+        start_millis_ = now_;
+        next_report_ = now_ + config_.report_ms;
+        Send(CDPro2::FOUND, 0x42, true);
+      }
+      break;
+
+    case CDPro2::SET_MODE: Send(CDPro2::MODE_STATUS, param, true); break;
+
+    default: Send(CDPro2::ERROR_VALUES, CDPro2::ILLEGAL_COMMAND, true); break;
+  }
+}
+
+void DsaPeer::StartPlay(uint32_t frames)
+{
+  playing_ = true;
+  paused_ = false;
+  start_frames_ = frames;
+  start_millis_ = now_;
+  next_report_ = now_ + config_.report_ms;
+  title_ = title_at(frames);
+  SendPosition(true);
+}
+
+void DsaPeer::Send(uint8_t response, uint8_t param, bool completes)
+{
+  uint8_t head = (tx_head_ + 1) % kMaxOutgoing;
+  if (head == tx_tail_) return;  // Overrun; the firmware isn't keeping up
+  tx_[tx_head_] = {DSA::Pack(response, param), completes};
+  tx_head_ = head;
+}
+
+void DsaPeer::SendPosition(bool title_changed)
+{
+  auto frames = position();
+  auto relative_seconds = (frames - title_start(title_at(frames))) / kFramesPerSecond;
+  auto absolute_seconds = frames / kFramesPerSecond;
+
+  if (title_changed) {
+    Send(CDPro2::ACTUAL_TITLE, title_at(frames));
+    Send(CDPro2::ACTUAL_INDEX, 1);
+  }
+  Send(CDPro2::ACTUAL_MINUTES, relative_seconds / 60);
+  Send(CDPro2::ACTUAL_SECONDS, relative_seconds % 60);
+  Send(CDPro2::ABSOLUTE_TIME_MINUTES, absolute_seconds / 60);
+  Send(CDPro2::ABSOLUTE_TIME_SECONDS, absolute_seconds % 60);
+  Send(CDPro2::ABSOLUTE_TIME_FRAMES, frames % kFramesPerSecond);
+}
+
+uint32_t DsaPeer::lead_out()
+{
+  return to_frames(config_.disc_time[0], config_.disc_time[1], config_.disc_time[2]);
+}
+
+uint32_t DsaPeer::title_start(uint8_t title)
+{
+  auto num_titles = 1 + config_.max_track - config_.min_track;
+  auto title_frames = (lead_out() - kPregapFrames) / num_titles;
+  return kPregapFrames + (title - config_.min_track) * title_frames;
+}
+
+uint8_t DsaPeer::title_at(uint32_t frames)
+{
+  uint8_t title = config_.min_track;
+  while (title < config_.max_track && frames >= title_start(title + 1)) ++title;
+  return title;
+}
+
+}  // namespace host
+
+// This is the seam: the firmware's DSA calls end up at the simulated peer
+
+PROGMEM_STRINGS5(dsa_status_strings, "OK", "ERR_SYNC", "ERR_DATA", "ERR_ACK", "ERR");
+const char *to_pstring(DSA::DSA_STATUS dsa_status)
+{
+  return avrx::pgm_read(&dsa_status_strings[dsa_status]);
+}
+
+void DSA::Init() {}
+
+bool DSA::TransmitRequested()
+{
+  return host::DsaPeer::transmit_requested();
+}
+
+DSA::ReceiveResult DSA::Receive()
+{
+  return host::DsaPeer::Receive();
+}
+
+DSA::DSA_STATUS DSA::Transmit(Message message)
+{
+  return host::DsaPeer::Transmit(message);
+}
+
+}  // namespace cdp
@@ -0,0 +1,154 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef HOST_DSA_PEER_H_
+#define HOST_DSA_PEER_H_
+
+#include <stdint.h>
+
+#include "drivers/dsa.h"
+
+namespace cdp {
+namespace host {
+
+// Simulated CD-Pro2 at the other end of the DSA link, for running cdpro2.cc on the host. The
+// DSA::* functions are implemented on top of this (instead of drivers/dsa.cc) so the firmware code
+// is unchanged.
+//
+// Only the parts of the protocol that the firmware actually uses are modelled: SPIN_UP, READ_TOC,
+// PLAY_TITLE, GOTO_TIME_*, STOP, PAUSE/PAUSE_RELEASE and SET_MODE, plus NO_DISC and error
+// responses. A new command replaces whatever is still scheduled from the previous one.
+//
+// The drive is powered when both the AUX_AC and AUX_9V relays are on, and ignores the bus for
+// boot_ms after that (transmits fail with STATUS_ERR_SYNC).
+//
+// NOTE All times are SysTick millis (1/1024s) like the rest of the firmware.
+class DsaPeer {
+public:
+  struct Config {
+    uint16_t boot_ms = 200;
+    uint16_t response_ms = 2;  // Commands that don't move anything
+    uint16_t spin_up_ms = 900;
+    uint16_t toc_ms = 1200;
+    uint16_t seek_ms = 350;
+    uint16_t stop_ms = 150;
+    uint16_t report_ms = 1024;  // ACTUAL_* and ABSOLUTE_TIME_* while playing
+
+    bool disc = true;
+    uint8_t min_track = 1;
+    uint8_t max_track = 14;
+    uint8_t disc_time[3] = {62, 31, 17};
+
+    // Transmits of this opcode fail (STATUS_ERR_ACK) fail_count times
+    uint8_t fail_opcode = 0;
+    uint8_t fail_count = 0;
+  };
+
+  struct Stats {
+    uint16_t commands = 0;
+    uint16_t retries = 0;  // Same command sent again after it didn't complete
+    uint16_t tx_errors = 0;
+    uint16_t responses = 0;
+    uint16_t completed = 0;
+    uint32_t latency_total = 0;
+    uint32_t latency_max = 0;
+  };
+
+  static void Reset(const Config &config);
+
+  // Advance to now; handles power changes, scheduled responses and position reports.
+  static void Tick(uint32_t now);
+
+  static const Stats &stats() { return stats_; }
+
+  // State for scenario scripts
+  static bool received(uint8_t opcode) { return received_[opcode]; }
+  static bool ready() { return ready_; }
+  static bool playing() { return playing_ && !paused_; }
+  static uint8_t title() { return title_; }
+  static uint32_t position();  // Absolute disc time in frames
+
+  // DSA implementation
+  static bool transmit_requested() { return tx_head_ != tx_tail_; }
+  static DSA::ReceiveResult Receive();
+  static DSA::DSA_STATUS Transmit(DSA::Message message);
+
+private:
+  static Config config_;
+  static Stats stats_;
+  static uint32_t now_;
+
+  static bool powered_;
+  static bool ready_;
+  static uint32_t ready_at_;
+  static bool received_[256];
+
+  // Position state
+  static bool spun_;
+  static bool toc_read_;
+  static bool playing_;
+  static bool paused_;
+  static uint8_t title_;
+  static uint32_t start_frames_;
+  static uint32_t start_millis_;
+  static uint32_t next_report_;
+  static uint8_t goto_time_[2];
+
+  // Command in progress
+  static DSA::Message command_;
+  static uint32_t command_millis_;
+  static bool command_completed_;
+  static DSA::Message unanswered_;  // Last command that was replaced before it completed
+
+  // At most one scheduled response per command, which runs at the given time
+  struct Scheduled {
+    uint32_t due = 0;
+    uint8_t opcode = 0;
+    uint8_t param = 0;
+    bool valid = false;
+  };
+  static Scheduled scheduled_;
+
+  // Messages that are ready to be sent to the firmware
+  struct Outgoing {
+    DSA::Message message;
+    bool completes;
+  };
+  static constexpr uint8_t kMaxOutgoing = 32;
+  static Outgoing tx_[kMaxOutgoing];
+  static uint8_t tx_head_, tx_tail_;
+
+  static void PowerOff();
+  static void Schedule(uint8_t opcode, uint8_t param, uint16_t delay);
+  static void Execute(uint8_t opcode, uint8_t param);
+  static void Send(uint8_t response, uint8_t param, bool completes = false);
+  static void SendPosition(bool title_changed);
+  static void StartPlay(uint32_t frames);
+
+  static uint32_t lead_out();
+  static uint32_t title_start(uint8_t title);
+  static uint8_t title_at(uint32_t frames);
+};
+
+}  // namespace host
+}  // namespace cdp
+
+#endif  // HOST_DSA_PEER_H_
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+#
+# cdpfw
+# Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+"""Serial monitor that decodes deferred traces (ENABLE_DEFERRED_TRACE).
+
+Text is passed through as-is. Frames (see serial_protocol.h) are decoded; MSG_TRACE
+frames are formatted using the format strings from the .trace_fmt section of the ELF,
+anything else is dumped as hex. Traces whose arguments were cut short on the device
+(MSG_TRACE_TRUNCATED) end in <truncated>.
+
+  trace_decode.py build/cdp_control.elf /dev/ttyUSB0 [baud]
+  trace_decode.py build/cdp_control.elf capture.bin
+"""
+
+import re
+import struct
+import sys
+
+MSG_RESPONSE = 0x80
+MSG_CVAR_NOTIFY = 0x40
+MSG_TRACE = 0x41
+MSG_TRACE_TRUNCATED = 0x42
+
+
+class Elf:
+    """Just enough ELF32 to read section contents by address."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1:
+            raise ValueError(f'{path}: not an ELF32 file')
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+        headers = [struct.unpack_from('<IIIIIIIIII', data, shoff + i * shentsize)
+                   for i in range(shnum)]
+        strtab = headers[shstrndx]
+        self.sections = {}
+        for name, _, _, addr, offset, size, *_ in headers:
+            end = data.index(b'\0', strtab[4] + name)
+            section_name = data[strtab[4] + name:end].decode()
+            self.sections[section_name] = (addr, data[offset:offset + size])
+
+    def string(self, section, addr):
+        base, data = self.sections[section]
+        offset = addr - base
+        if not 0 <= offset < len(data):
+            return None
+        return data[offset:data.index(b'\0', offset)].decode(errors='replace')
+
+
+FORMAT_SPEC = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(l?)([diuxXcsSp%])')
+
+
+def format_trace(fmt, args, elf, truncated=False):
+    """printf with the AVR argument sizes (int = 16 bits), see serial_trace.h"""
+    out = []
+    pos = 0
+    for m in FORMAT_SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, long_, conv = m.groups()
+        if '%' == conv:
+            out.append('%')
+            continue
+        spec = '%' + flags + width + ('.' + precision if precision else '')
+        if conv == 's':
+            end = args.index(0) if 0 in args else len(args)
+            value, args = args[:end].decode(errors='replace'), args[end + 1:]
+            out.append((spec + 's') % value)
+            continue
+        size = 4 if long_ else 2
+        if len(args) < size:
+            if truncated:
+                break
+            out.append('<?>')
+            continue
+        value, args = int.from_bytes(args[:size], 'little'), args[size:]
+        if conv == 'S':
+            out.append((spec + 's') % (elf.string('.text', value) or f'<{value:#06x}>'))
+        elif conv in 'di':
+            if value & (1 << (size * 8 - 1)):
+                value -= 1 << (size * 8)
+            out.append((spec + 'd') % value)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xff))
+        elif conv == 'p':
+            out.append(f'{value:#06x}')
+        else:
+            out.append((spec + conv) % value)
+    else:
+        out.append(fmt[pos:])
+    if truncated:
+        out.append('<truncated>')
+    return ''.join(out)
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xff if crc & 0x80 else (crc << 1) & 0xff
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if not code or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if i < len(data) and code != 0xff:
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, elf):
+        self.elf = elf
+        self.frame = None
+        self.seq = None
+
+    def frame_received(self, encoded):
+        frame = cobs_decode(encoded)
+        if not frame or len(frame) < 3 or crc8(frame):
+            print(f'[bad frame {encoded.hex(" ")}]')
+            return
+        seq, type_, payload = frame[0], frame[1], frame[2:-1]
+        if type_ in (MSG_TRACE, MSG_TRACE_TRUNCATED) and len(payload) >= 2:
+            if self.seq is not None and seq != (self.seq + 1) & 0xff:
+                print(f'[{(seq - self.seq - 1) & 0xff} trace(s) dropped]')
+            self.seq = seq
+            trace_id = payload[0] | (payload[1] << 8)
+            fmt = self.elf.string('.trace_fmt', trace_id)
+            if fmt is None:
+                print(f'[unknown trace {trace_id:#06x} {payload[2:].hex(" ")}]')
+            else:
+                truncated = MSG_TRACE_TRUNCATED == type_
+                print(format_trace(fmt.rstrip('\r\n'), payload[2:], self.elf, truncated))
+        else:
+            print(f'[frame seq={seq} type={type_:#04x} {payload.hex(" ")}]')
+
+    def feed(self, data):
+        for b in data:
+            if 0 == b:
+                if self.frame:
+                    self.frame_received(bytes(self.frame))
+                    self.frame = None
+                else:
+                    self.frame = bytearray()
+            elif self.frame is not None:
+                self.frame.append(b)
+            elif b != ord('\r'):
+                sys.stdout.write(chr(b))
+        sys.stdout.flush()
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    decoder = Decoder(Elf(sys.argv[1]))
+    source = sys.argv[2]
+    if source.startswith('/dev/'):
+        import serial  # pyserial
+        port = serial.Serial(source, int(sys.argv[3]) if len(sys.argv) > 3 else 115200)
+        while True:
+            decoder.feed(port.read(port.in_waiting or 1))
+    else:
+        with open(source, 'rb') if source != '-' else sys.stdin.buffer as f:
+            decoder.feed(f.read())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,521 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "vfd_emulator.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "avrx/host/avrx_host.h"
+#include "drivers/gpio.h"
+
+namespace cdp {
+namespace host {
+
+namespace {
+
+// Column bitmaps, LSB at the top
+const uint8_t font_5x7[][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5f, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7f, 0x14, 0x7f, 0x14}, {0x24, 0x2a, 0x7f, 0x2a, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1c, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1c, 0x00}, {0x14, 0x08, 0x3e, 0x08, 0x14}, {0x08, 0x08, 0x3e, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3e, 0x51, 0x49, 0x45, 0x3e}, {0x00, 0x42, 0x7f, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4b, 0x31}, {0x18, 0x14, 0x12, 0x7f, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3c, 0x4a, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1e}, {0x00, 0x36, 0x36, 0x00, 0x00},
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3e},
+    {0x7e, 0x11, 0x11, 0x11, 0x7e}, {0x7f, 0x49, 0x49, 0x49, 0x36}, {0x3e, 0x41, 0x41, 0x41, 0x22},
+    {0x7f, 0x41, 0x41, 0x22, 0x1c}, {0x7f, 0x49, 0x49, 0x49, 0x41}, {0x7f, 0x09, 0x09, 0x09, 0x01},
+    {0x3e, 0x41, 0x49, 0x49, 0x7a}, {0x7f, 0x08, 0x08, 0x08, 0x7f}, {0x00, 0x41, 0x7f, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3f, 0x01}, {0x7f, 0x08, 0x14, 0x22, 0x41}, {0x7f, 0x40, 0x40, 0x40, 0x40},
+    {0x7f, 0x02, 0x0c, 0x02, 0x7f}, {0x7f, 0x04, 0x08, 0x10, 0x7f}, {0x3e, 0x41, 0x41, 0x41, 0x3e},
+    {0x7f, 0x09, 0x09, 0x09, 0x06}, {0x3e, 0x41, 0x51, 0x21, 0x5e}, {0x7f, 0x09, 0x19, 0x29, 0x46},
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7f, 0x01, 0x01}, {0x3f, 0x40, 0x40, 0x40, 0x3f},
+    {0x1f, 0x20, 0x40, 0x20, 0x1f}, {0x3f, 0x40, 0x38, 0x40, 0x3f}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7f, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7f, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7f, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7f},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7e, 0x09, 0x01, 0x02}, {0x0c, 0x52, 0x52, 0x52, 0x3e},
+    {0x7f, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7d, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3d, 0x00},
+    {0x7f, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7f, 0x40, 0x00}, {0x7c, 0x04, 0x18, 0x04, 0x78},
+    {0x7c, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7c, 0x14, 0x14, 0x14, 0x08},
+    {0x08, 0x14, 0x14, 0x18, 0x7c}, {0x7c, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3f, 0x44, 0x40, 0x20}, {0x3c, 0x40, 0x40, 0x20, 0x7c}, {0x1c, 0x20, 0x40, 0x20, 0x1c},
+    {0x3c, 0x40, 0x30, 0x40, 0x3c}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0c, 0x50, 0x50, 0x50, 0x3c},
+    {0x44, 0x64, 0x54, 0x4c, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7f, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x10, 0x08, 0x08, 0x10, 0x08},
+};
+
+// Upper case only
+const uint8_t font_3x5[][3] = {
+    {0x00, 0x00, 0x00}, {0x00, 0x17, 0x00}, {0x03, 0x00, 0x03}, {0x1f, 0x0a, 0x1f},
+    {0x16, 0x1f, 0x0d}, {0x19, 0x04, 0x13}, {0x0a, 0x15, 0x1a}, {0x00, 0x03, 0x00},
+    {0x00, 0x0e, 0x11}, {0x11, 0x0e, 0x00}, {0x05, 0x02, 0x05}, {0x04, 0x0e, 0x04},
+    {0x10, 0x08, 0x00}, {0x04, 0x04, 0x04}, {0x00, 0x10, 0x00}, {0x18, 0x04, 0x03},
+    {0x1f, 0x11, 0x1f}, {0x12, 0x1f, 0x10}, {0x1d, 0x15, 0x17}, {0x11, 0x15, 0x1f},
+    {0x07, 0x04, 0x1f}, {0x17, 0x15, 0x1d}, {0x1f, 0x15, 0x1d}, {0x01, 0x01, 0x1f},
+    {0x1f, 0x15, 0x1f}, {0x17, 0x15, 0x1f}, {0x00, 0x0a, 0x00}, {0x10, 0x0a, 0x00},
+    {0x04, 0x0a, 0x11}, {0x0a, 0x0a, 0x0a}, {0x11, 0x0a, 0x04}, {0x01, 0x15, 0x03},
+    {0x0e, 0x15, 0x16}, {0x1e, 0x05, 0x1e}, {0x1f, 0x15, 0x0a}, {0x0e, 0x11, 0x11},
+    {0x1f, 0x11, 0x0e}, {0x1f, 0x15, 0x11}, {0x1f, 0x05, 0x01}, {0x0e, 0x11, 0x1d},
+    {0x1f, 0x04, 0x1f}, {0x11, 0x1f, 0x11}, {0x08, 0x10, 0x0f}, {0x1f, 0x04, 0x1b},
+    {0x1f, 0x10, 0x10}, {0x1f, 0x06, 0x1f}, {0x1f, 0x0e, 0x1f}, {0x0e, 0x11, 0x0e},
+    {0x1f, 0x05, 0x02}, {0x0e, 0x19, 0x1e}, {0x1f, 0x0d, 0x16}, {0x12, 0x15, 0x09},
+    {0x01, 0x1f, 0x01}, {0x0f, 0x10, 0x1f}, {0x07, 0x18, 0x07}, {0x1f, 0x0c, 0x1f},
+    {0x1b, 0x04, 0x1b}, {0x03, 0x1c, 0x03}, {0x19, 0x15, 0x13}, {0x1f, 0x11, 0x11},
+    {0x03, 0x04, 0x18}, {0x11, 0x11, 0x1f}, {0x02, 0x01, 0x02}, {0x10, 0x10, 0x10},
+};
+
+struct Font {
+  uint8_t id;
+  uint8_t width, height;
+  uint8_t scale;
+  const uint8_t *data;
+  uint8_t count;
+};
+
+const Font fonts[] = {
+    {VFD::FONT_5x7, 5, 7, 1, font_5x7[0], sizeof(font_5x7) / sizeof(font_5x7[0])},
+    {VFD::FONT_MINI, 3, 5, 1, font_3x5[0], sizeof(font_3x5) / sizeof(font_3x5[0])},
+    {VFD::FONT_10x14, 5, 7, 2, font_5x7[0], sizeof(font_5x7) / sizeof(font_5x7[0])},
+};
+
+const Font *find_font(uint8_t id)
+{
+  for (auto &font : fonts)
+    if (font.id == id) return &font;
+  return &fonts[0];
+}
+
+constexpr uint8_t kTextColumns = 40;
+constexpr uint8_t kCellWidth = 7;
+constexpr uint8_t kCellHeight = 8;
+
+enum Command : uint8_t {
+  DISPLAY_CLEAR = 0x01,
+  CURSOR_HOME = 0x02,
+  DISPLAY_CONTROL = 0x08,
+  FUNCTION_SET = 0x20,
+  FUNCTION_SET_8BIT = 0x10,
+  SET_DDRAM_ADDRESS = 0x80,
+  SET_GRAPHIC_CURSOR = 0xf0,
+  WRITE_GRAPHIC_IMAGE = 0xf1,
+  SET_FONT = 0xf2,
+};
+
+}  // namespace
+
+/*static*/ VfdEmulator::Stats VfdEmulator::stats_;
+/*static*/ uint32_t VfdEmulator::frame_bytes_ = 0;
+
+/*static*/ bool VfdEmulator::eight_bit_ = true;
+/*static*/ bool VfdEmulator::nibble_pending_ = false;
+/*static*/ uint8_t VfdEmulator::nibble_ = 0;
+/*static*/ bool VfdEmulator::strobe_ = false;
+
+/*static*/ bool VfdEmulator::framebuffer_[kHeight][kWidth];
+/*static*/ bool VfdEmulator::powered_ = false;
+/*static*/ uint8_t VfdEmulator::brightness_ = 0;
+/*static*/ bool VfdEmulator::expect_brightness_ = false;
+/*static*/ VfdEmulator::Mode VfdEmulator::mode_ = VfdEmulator::MODE_TEXT;
+/*static*/ uint8_t VfdEmulator::text_line_ = 0;
+/*static*/ uint8_t VfdEmulator::text_col_ = 0;
+/*static*/ uint16_t VfdEmulator::cursor_x_ = 0;
+/*static*/ uint8_t VfdEmulator::cursor_y_ = 0;
+/*static*/ uint8_t VfdEmulator::font_ = VFD::FONT_5x7;
+/*static*/ uint8_t VfdEmulator::font_spacing_ = 1;
+
+/*static*/ uint8_t VfdEmulator::command_ = 0;
+/*static*/ uint8_t VfdEmulator::params_[7];
+/*static*/ uint8_t VfdEmulator::param_count_ = 0;
+/*static*/ uint8_t VfdEmulator::param_len_ = 0;
+/*static*/ uint16_t VfdEmulator::image_bytes_ = 0;
+/*static*/ uint16_t VfdEmulator::image_pos_ = 0;
+
+/*static*/ void VfdEmulator::Reset()
+{
+  stats_ = Stats{};
+  frame_bytes_ = 0;
+
+  eight_bit_ = true;
+  nibble_pending_ = false;
+  strobe_ = false;
+
+  memset(framebuffer_, 0, sizeof(framebuffer_));
+  powered_ = false;
+  brightness_ = 0;
+  expect_brightness_ = false;
+  mode_ = MODE_TEXT;
+  text_line_ = text_col_ = 0;
+  cursor_x_ = cursor_y_ = 0;
+  font_ = VFD::FONT_5x7;
+  font_spacing_ = 1;
+
+  param_count_ = param_len_ = 0;
+  image_bytes_ = image_pos_ = 0;
+
+  avrx::host::SetRegisterWriteHook(RegisterWritten);
+}
+
+/*static*/ uint32_t VfdEmulator::EndFrame()
+{
+  auto bytes = frame_bytes_;
+  frame_bytes_ = 0;
+  return bytes;
+}
+
+/*static*/ void VfdEmulator::RegisterWritten(volatile void *reg)
+{
+  using E = gpio::DISP_E;
+  if (reg != E::Port::OutputRegister::ptr()) return;
+
+  bool strobe = E::Port::OutputRegister::Read() & E::OutputBit::Mask;
+  if (strobe_ && !strobe) {
+    bool rs = gpio::DISP_RS::Port::OutputRegister::Read() & gpio::DISP_RS::OutputBit::Mask;
+    uint8_t bits = 0;
+    if (gpio::DISP_D4::Port::OutputRegister::Read() & gpio::DISP_D4::OutputBit::Mask) bits |= 0x10;
+    if (gpio::DISP_D5::Port::OutputRegister::Read() & gpio::DISP_D5::OutputBit::Mask) bits |= 0x20;
+    if (gpio::DISP_D6::Port::OutputRegister::Read() & gpio::DISP_D6::OutputBit::Mask) bits |= 0x40;
+    if (gpio::DISP_D7::Port::OutputRegister::Read() & gpio::DISP_D7::OutputBit::Mask) bits |= 0x80;
+    Strobe(rs, bits);
+  }
+  strobe_ = strobe;
+}
+
+// D0-D3 aren't connected, so in 8-bit mode each strobe is a byte with the lower bits clear.
+/*static*/ void VfdEmulator::Strobe(bool rs, uint8_t bits)
+{
+  if (eight_bit_) {
+    Write(rs, bits);
+  } else if (!nibble_pending_) {
+    nibble_ = bits;
+    nibble_pending_ = true;
+  } else {
+    nibble_pending_ = false;
+    Write(rs, nibble_ | (bits >> 4));
+  }
+}
+
+/*static*/ void VfdEmulator::Write(bool data, uint8_t byte)
+{
+  ++stats_.bytes;
+  ++frame_bytes_;
+  if (data)
+    Data(byte);
+  else
+    Command(byte);
+}
+
+/*static*/ void VfdEmulator::Command(uint8_t command)
+{
+  ++stats_.commands;
+  expect_brightness_ = false;
+  param_count_ = param_len_ = 0;
+  image_bytes_ = 0;
+  command_ = command;
+
+  switch (command) {
+    case SET_GRAPHIC_CURSOR: param_len_ = 3; return;
+    case WRITE_GRAPHIC_IMAGE: param_len_ = 7; return;
+    case SET_FONT: param_len_ = 1; return;
+    default: break;
+  }
+
+  if (command & SET_DDRAM_ADDRESS) {
+    mode_ = MODE_TEXT;
+    text_line_ = (command & 0x40) ? 1 : 0;
+    text_col_ = command & 0x3f;
+  } else if (command & FUNCTION_SET) {
+    eight_bit_ = command & FUNCTION_SET_8BIT;
+    expect_brightness_ = true;
+  } else if (command & DISPLAY_CONTROL) {
+    powered_ = command & VFD::POWER_ON;
+  } else if (command & CURSOR_HOME) {
+    mode_ = MODE_TEXT;
+    text_line_ = text_col_ = 0;
+  } else if (command & DISPLAY_CLEAR) {
+    memset(framebuffer_, 0, sizeof(framebuffer_));
+    mode_ = MODE_TEXT;
+    text_line_ = text_col_ = 0;
+  } else {
+    ++stats_.unknown;
+  }
+}
+
+/*static*/ void VfdEmulator::Data(uint8_t data)
+{
+  if (image_bytes_) {
+    ImageData(data);
+  } else if (param_count_ < param_len_) {
+    params_[param_count_++] = data;
+    if (param_count_ == param_len_) ExecuteCommand();
+  } else if (expect_brightness_) {
+    brightness_ = data & 0x3;
+    expect_brightness_ = false;
+  } else if (MODE_TEXT == mode_) {
+    if (text_col_ < kTextColumns) {
+      uint16_t x = text_col_ * kCellWidth;
+      int16_t y = text_line_ * kCellHeight;
+      Fill(x, y, x + kCellWidth - 1, y + kCellHeight - 1, false);
+      DrawGlyph(x + 1, y, VFD::FONT_5x7, data, 0);
+      ++text_col_;
+    }
+  } else {
+    auto font = find_font(font_);
+    cursor_x_ += DrawGlyph(cursor_x_, cursor_y_ - font->height * font->scale, font_, data,
+                           font_spacing_);
+  }
+}
+
+/*static*/ void VfdEmulator::ExecuteCommand()
+{
+  switch (command_) {
+    case SET_GRAPHIC_CURSOR:
+      mode_ = MODE_GRAPHIC;
+      cursor_x_ = (params_[0] << 8) | params_[1];
+      cursor_y_ = params_[2];
+      break;
+    case SET_FONT:
+      if ('1' == params_[0] || '2' == params_[0])
+        font_spacing_ = params_[0] - '0';
+      else
+        font_ = params_[0];
+      break;
+    case WRITE_GRAPHIC_IMAGE: {
+      uint16_t x1 = (params_[0] << 8) | params_[1];
+      uint8_t y1 = params_[2];
+      uint16_t x2 = (params_[3] << 8) | params_[4];
+      uint8_t y2 = params_[5];
+      switch (params_[6]) {
+        case 'C': Fill(x1, y1, x2, y2, false); break;
+        case 'F': Fill(x1, y1, x2, y2, true); break;
+        case 'O':
+          Fill(x1, y1, x2, y1, true);
+          Fill(x1, y2, x2, y2, true);
+          Fill(x1, y1, x1, y2, true);
+          Fill(x2, y1, x2, y2, true);
+          break;
+        case 'h':
+          if (x2 >= x1 && y2 >= y1) {
+            image_bytes_ = ((x2 - x1 + 8) / 8) * (y2 - y1 + 1);
+            image_pos_ = 0;
+          }
+          break;
+        default: ++stats_.unknown; break;
+      }
+    } break;
+    default: break;
+  }
+}
+
+/*static*/ void VfdEmulator::ImageData(uint8_t data)
+{
+  uint16_t x1 = (params_[0] << 8) | params_[1];
+  uint8_t y1 = params_[2];
+  uint8_t h = params_[5] - y1 + 1;
+  uint16_t x2 = (params_[3] << 8) | params_[4];
+
+  uint16_t x = x1 + (image_pos_ / h) * 8;
+  uint8_t y = y1 + image_pos_ % h;
+  for (uint8_t bit = 0; bit < 8 && x + bit <= x2; ++bit) Set(x + bit, y, data & (0x80 >> bit));
+
+  ++image_pos_;
+  --image_bytes_;
+}
+
+/*static*/ void VfdEmulator::Fill(uint16_t x1, uint8_t y1, uint16_t x2, uint8_t y2, bool value)
+{
+  for (uint16_t y = y1; y <= y2; ++y)
+    for (uint16_t x = x1; x <= x2; ++x) Set(x, y, value);
+}
+
+/*static*/ void VfdEmulator::Set(uint16_t x, int16_t y, bool value)
+{
+  if (x < kWidth && y >= 0 && y < kHeight) framebuffer_[y][x] = value;
+}
+
+// Draws the glyph and clears the spacing after it, returns the total width
+/*static*/ uint8_t VfdEmulator::DrawGlyph(uint16_t x, int16_t y, uint8_t font_id, uint8_t c,
+                                          uint8_t spacing)
+{
+  auto font = find_font(font_id);
+  const uint8_t w = font->width * font->scale;
+  const uint8_t h = font->height * font->scale;
+
+  if (VFD::FONT_MINI == font_id) c = toupper(c);
+  const uint8_t *glyph = nullptr;
+  if (c >= ' ' && c - ' ' < font->count) glyph = font->data + (c - ' ') * font->width;
+
+  for (uint8_t i = 0; i < w + spacing; ++i) {
+    for (uint8_t j = 0; j < h; ++j) {
+      bool value = false;
+      if (i >= w)
+        value = false;
+      else if (glyph)
+        value = glyph[i / font->scale] & (1 << (j / font->scale));
+      else
+        value = !i || !j || i == w - 1 || j == h - 1;
+      Set(x + i, y + j, value);
+    }
+  }
+  return w + spacing;
+}
+
+/*static*/ uint32_t VfdEmulator::checksum()
+{
+  uint32_t sum = 2166136261u;  // FNV-1a
+  auto p = &framebuffer_[0][0];
+  for (size_t i = 0; i < sizeof(framebuffer_); ++i) sum = (sum ^ p[i]) * 16777619u;
+  sum = (sum ^ powered_) * 16777619u;
+  return (sum ^ brightness_) * 16777619u;
+}
+
+// Cyan-ish, unlit pixels are slightly visible
+/*static*/ void VfdEmulator::Rgb(uint16_t x, uint8_t y, uint8_t *rgb)
+{
+  static constexpr uint8_t kLit[3] = {0x40, 0xff, 0xd8};
+  static constexpr uint8_t kUnlit[3] = {0x18, 0x20, 0x20};
+  if (powered_ && framebuffer_[y][x]) {
+    for (int i = 0; i < 3; ++i) rgb[i] = kLit[i] * (4 - brightness_) / 4;
+  } else {
+    memcpy(rgb, kUnlit, 3);
+  }
+}
+
+/*static*/ bool VfdEmulator::WritePPM(const char *filename, uint8_t scale)
+{
+  auto f = fopen(filename, "wb");
+  if (!f) return false;
+
+  fprintf(f, "P6\n%u %u\n255\n", kWidth * scale, kHeight * scale);
+  uint8_t rgb[3];
+  for (uint16_t y = 0; y < kHeight * scale; ++y) {
+    for (uint16_t x = 0; x < kWidth * scale; ++x) {
+      Rgb(x / scale, y / scale, rgb);
+      fwrite(rgb, 3, 1, f);
+    }
+  }
+  return 0 == fclose(f);
+}
+
+namespace {
+
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ (0xedb88320u & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+void put32(uint8_t *p, uint32_t value)
+{
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+void WriteChunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+  uint8_t header[8];
+  put32(header, len);
+  memcpy(header + 4, type, 4);
+  fwrite(header, 8, 1, f);
+  if (len) fwrite(data, len, 1, f);
+  uint8_t crc[4];
+  put32(crc, crc32(crc32(0, header + 4, 4), data, len));
+  fwrite(crc, 4, 1, f);
+}
+
+}  // namespace
+
+// Uncompressed (stored deflate blocks) since the images are small and this avoids a zlib dependency
+/*static*/ bool VfdEmulator::WritePNG(const char *filename, uint8_t scale)
+{
+  const uint32_t w = kWidth * scale;
+  const uint32_t h = kHeight * scale;
+  const uint32_t stride = 1 + w * 3;
+  const uint32_t raw_len = stride * h;
+
+  std::vector<uint8_t> raw(raw_len);
+  for (uint32_t y = 0; y < h; ++y) {
+    auto row = raw.data() + y * stride;
+    row[0] = 0;  // No filter
+    for (uint32_t x = 0; x < w; ++x) Rgb(x / scale, y / scale, row + 1 + x * 3);
+  }
+
+  // zlib stream of stored blocks
+  const uint32_t kMaxBlock = 65535;
+  const uint32_t blocks = (raw_len + kMaxBlock - 1) / kMaxBlock;
+  std::vector<uint8_t> idat(raw_len + blocks * 5 + 6);
+  uint8_t *p = idat.data();
+  *p++ = 0x78;
+  *p++ = 0x01;
+  uint32_t a = 1, b = 0;
+  for (uint32_t i = 0; i < raw_len; ++i) {
+    a = (a + raw[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  for (uint32_t i = 0; i < blocks; ++i) {
+    uint32_t offset = i * kMaxBlock;
+    uint16_t len = raw_len - offset < kMaxBlock ? raw_len - offset : kMaxBlock;
+    *p++ = (i == blocks - 1) ? 1 : 0;
+    *p++ = len;
+    *p++ = len >> 8;
+    *p++ = ~len;
+    *p++ = (uint16_t)~len >> 8;
+    memcpy(p, raw.data() + offset, len);
+    p += len;
+  }
+  put32(p, (b << 16) | a);
+  p += 4;
+
+  auto f = fopen(filename, "wb");
+  if (!f) return false;
+
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  fwrite(signature, 8, 1, f);
+  uint8_t ihdr[13];
+  put32(ihdr, w);
+  put32(ihdr + 4, h);
+  ihdr[8] = 8;   // Bit depth
+  ihdr[9] = 2;   // RGB
+  ihdr[10] = 0;  // Compression
+  ihdr[11] = 0;  // Filter
+  ihdr[12] = 0;  // No interlace
+  WriteChunk(f, "IHDR", ihdr, sizeof(ihdr));
+  WriteChunk(f, "IDAT", idat.data(), p - idat.data());
+  WriteChunk(f, "IEND", nullptr, 0);
+  return 0 == fclose(f);
+}
+
+}  // namespace host
+}  // namespace cdp
@@ -0,0 +1,127 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef HOST_VFD_EMULATOR_H_
+#define HOST_VFD_EMULATOR_H_
+
+#include <stdint.h>
+
+#include "drivers/vfd.h"
+
+namespace cdp {
+namespace host {
+
+// Emulated GU280x16 display for the host build. drivers/vfd.cc is used unchanged: the emulator
+// watches the DISP_* pins through the avrx host register hook and latches D4-D7/RS on the falling
+// edge of E, so it sees exactly the nibbles that the firmware sends (including the 8-bit init
+// sequence).
+//
+// The command subset is what the firmware uses:
+// - Clear/home, display on/off, function set (+ brightness data byte)
+// - Text mode: 2 lines x 40 columns of 5x7 characters in 7x8 cells
+// - SET_GRAPHIC_CURSOR (x, y), where y is the row below the glyphs
+// - WRITE_GRAPHIC_IMAGE areas with 'C' (clear), 'F' (fill), 'O' (outline) and 'h' (image data,
+//   one byte per 8 horizontal pixels MSB first, in 8 pixel wide bands top to bottom)
+// - SET_FONT with 5x7, mini (3x5), 10x14 and 1px/2px spacing
+//
+// NOTE The glyphs are a generic 5x7 set and not a dump of the module's character ROM, so rendered
+// text is close but not pixel identical. Characters that have no glyph are drawn as a box.
+class VfdEmulator {
+public:
+  static constexpr uint16_t kWidth = VFD::kWidth;
+  static constexpr uint8_t kHeight = VFD::kHeight;
+
+  struct Stats {
+    uint32_t bytes = 0;
+    uint32_t commands = 0;
+    uint32_t unknown = 0;  // Commands or image modes the emulator doesn't understand
+  };
+
+  // Reset to power-on state and start listening to the pins
+  static void Reset();
+
+  // Byte level interface
+  static void Write(bool data, uint8_t byte);
+
+  static const Stats &stats() { return stats_; }
+
+  // Returns the number of bytes written since the last call
+  static uint32_t EndFrame();
+
+  static bool pixel(uint16_t x, uint8_t y) { return framebuffer_[y][x]; }
+  static bool powered() { return powered_; }
+  static uint8_t brightness() { return brightness_; }  // 0 = 100% ... 3 = 25%
+
+  // Compare two framebuffers, e.g. to only write changed frames
+  static uint32_t checksum();
+
+  // Write the current state as image file, each pixel is scaled by `scale`
+  static bool WritePPM(const char *filename, uint8_t scale);
+  static bool WritePNG(const char *filename, uint8_t scale);
+
+private:
+  enum Mode : uint8_t { MODE_TEXT, MODE_GRAPHIC };
+
+  static Stats stats_;
+  static uint32_t frame_bytes_;
+
+  // Bus state
+  static bool eight_bit_;
+  static bool nibble_pending_;
+  static uint8_t nibble_;
+  static bool strobe_;
+
+  // Display state
+  static bool framebuffer_[kHeight][kWidth];
+  static bool powered_;
+  static uint8_t brightness_;
+  static bool expect_brightness_;
+  static Mode mode_;
+  static uint8_t text_line_, text_col_;
+  static uint16_t cursor_x_;
+  static uint8_t cursor_y_;
+  static uint8_t font_;
+  static uint8_t font_spacing_;
+
+  // Command parameters
+  static uint8_t command_;
+  static uint8_t params_[7];
+  static uint8_t param_count_, param_len_;
+  static uint16_t image_bytes_, image_pos_;
+
+  static void RegisterWritten(volatile void *reg);
+  static void Strobe(bool rs, uint8_t bits);
+
+  static void Command(uint8_t command);
+  static void Data(uint8_t data);
+  static void ExecuteCommand();
+  static void ImageData(uint8_t data);
+
+  static void Fill(uint16_t x1, uint8_t y1, uint16_t x2, uint8_t y2, bool value);
+  static void Set(uint16_t x, int16_t y, bool value);
+  static uint8_t DrawGlyph(uint16_t x, int16_t y, uint8_t font, uint8_t c, uint8_t spacing);
+  static void Rgb(uint16_t x, uint8_t y, uint8_t *rgb);
+};
+
+}  // namespace host
+}  // namespace cdp
+
+#endif  // HOST_VFD_EMULATOR_H_
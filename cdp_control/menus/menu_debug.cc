@@ -47,12 +47,12 @@ public:
   static void Draw()
   {
     VFD::SetCursor(0, 0);
-    VFD::PrintfP(PSTR("SENS %03u"), CoverSensor::threshold());
-    VFD::PrintfP(PSTR(" SRC %u"), debug_info.src_init);
+    VFD::Print(FMT_P("SENS %03u"), CoverSensor::threshold());
+    VFD::Print(FMT_P(" SRC %u"), debug_info.src_init);
 
     VFD::SetCursor(1, 0);
-    VFD::PrintfP(PSTR("%S %03u"), global_state.lid_open ? PSTR("OPEN") : PSTR("CLOS"),
-                 CoverSensor::value());
+    VFD::Print(FMT_P("%S %03u"), global_state.lid_open ? PSTR("OPEN") : PSTR("CLOS"),
+               CoverSensor::value());
   }
 };
 
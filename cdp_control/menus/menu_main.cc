@@ -19,7 +19,6 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,7 +36,6 @@
 
 namespace cdp {
 
-static char status_buffer[40];
 
 static DisplayArea<165, 0, VFD::kWidth - 165, VFD::kHeight> volume_overlay;
 static GraphicText<0, 0, 165 - 16, 7, VFD::FONT_MINI, 1> source_info_text;
@@ -69,9 +67,9 @@ static void RatioToString(uint16_t ratio)
     auto integral = f / 10;
     auto fractional = f - (integral * 10);
     if (fractional)
-      sprintf_P(ratio_buffer, PSTR("%d.%d KHz"), integral, fractional);
+      util::FormatTo(ratio_buffer, FMT_P("%d.%d KHz"), integral, fractional);
     else
-      sprintf_P(ratio_buffer, PSTR("%4d KHz"), integral);
+      util::FormatTo(ratio_buffer, FMT_P("%4d KHz"), integral);
   }
 }
 
@@ -92,8 +90,7 @@ public:
     if (disp_volume_overlay_ && TimerSlots::elapsed(TIMER_SLOT_VOL)) HideVolumeOverlay();
     if (disp_source_info_ && TimerSlots::elapsed(TIMER_SLOT_SRC)) HideSourceInfo();
 
-    if (global_state.src4392.mute.dirty() || global_state.src4392.attenuation.dirty())
-      ShowVolumeOverlay();
+    if (SRCState::dirty(SRCState::DIRTY_MUTE | SRCState::DIRTY_ATTENUATION)) ShowVolumeOverlay();
 
     bool show_source = global_state.src4392.source.dirty();
     if (global_state.src4392.ratio.dirty()) {
@@ -116,11 +113,30 @@ public:
   {
     switch (event.control.id) {
       case UI::CONTROL_ENC: {
-        int att = util::clamp(global_state.src4392.attenuation - event.control.value, 0, 255);
-        global_state.src4392.attenuation = att;
+        // Turning while the encoder is pressed scans instead of changing the volume
+        if (enc_pressed_) {
+          enc_turned_ = true;
+          CDPlayer::Scan(event.control.value);
+        } else {
+          int att = util::clamp(global_state.src4392.attenuation - event.control.value, 0, 255);
+          global_state.src4392.attenuation = att;
+        }
       } break;
       case UI::CONTROL_SW_ENC: {
-        if (event.control.value) { global_state.src4392.toggle_mute(); }
+        // So mute happens on release, unless it was used for scanning
+        if (event.control.value) {
+          enc_pressed_ = true;
+          enc_turned_ = false;
+        } else {
+          if (enc_pressed_ && !enc_turned_) global_state.src4392.toggle_mute();
+          enc_pressed_ = false;
+        }
+      } break;
+      case UI::CONTROL_SW_PREV: {
+        if (event.control.value) CDPlayer::PrevTitle();
+      } break;
+      case UI::CONTROL_SW_NEXT: {
+        if (event.control.value) CDPlayer::NextTitle();
       } break;
       case UI::CONTROL_SW_MENU: {
         if (event.control.value) Menus::set_current(&menu_settings);
@@ -132,31 +148,38 @@ public:
 
   static void Draw()
   {
+    Scratch::Frame scratch;
+    auto status_buffer = scratch.Alloc<char>(CDPlayer::kStatusLength);
+    if (!status_buffer) return;
+    const auto status_end = status_buffer + CDPlayer::kStatusLength;
+
     CDPlayer::GetStatus(status_buffer);
 
     // Avoid clear + draw if string length changes. Super efficient :]
     auto p = status_buffer + strlen(status_buffer);
-    while (p < status_buffer + sizeof(status_buffer) - 1) *p++ = ' ';
+    while (p < status_end - 1) *p++ = ' ';
+    *p = 0;
     // VFD::SetGraphicCursor(0, 16);
     // VFD::SetFont(VFD::FONT_5x7);
     VFD::SetCursor(1, 0);
-    VFD::Printf("%.23s", status_buffer);
+    VFD::Print(FMT_P("%.23s"), status_buffer);
 
     if (source_info_text.is_dirty()) {
       source_info_text.Draw();
       VFD::SetGraphicCursor(0, 6);
       if (disp_source_info_) {
-        VFD::PrintfP(PSTR("%S  %s"), to_pstring(global_state.src4392.source), ratio_buffer);
+        VFD::Print(FMT_P("%S  %s"), to_pstring(global_state.src4392.source), ratio_buffer);
       } else {
-        VFD::PrintfP(PSTR("%s"), ratio_buffer);
+        VFD::Print(ratio_buffer);
       }
     }
 
     if (volume_overlay.is_dirty()) {
       const bool mute = global_state.src4392.mute;
       const uint8_t db = global_state.src4392.attenuation;
-      auto w =
-          sprintf_P(status_buffer, PSTR(" %c%d.%ddB"), db ? '-' : ' ', (db >> 1), (db & 1) ? 5 : 0);
+      auto end = util::FormatTo(status_buffer, status_end, FMT_P(" %c%d.%ddB"), db ? '-' : ' ',
+                                (db >> 1), (db & 1) ? 5 : 0);
+      auto w = end - status_buffer;
 
       volume_overlay.Draw();
       if (disp_volume_overlay_) {
@@ -168,10 +191,10 @@ public:
         VFD::SetFont(VFD::FONT_10x14);
         VFD::SetFont(VFD::FONT_1px);
         VFD::SetGraphicCursor(280 - w * 11, 16);
-        VFD::Printf(status_buffer);
+        VFD::Print(status_buffer);
       } else {
         VFD::SetCursor(1, 40 - w);
-        VFD::Printf(status_buffer);
+        VFD::Print(status_buffer);
 
         VFD::SetFont(VFD::FONT_MINI);
         VFD::SetFont(VFD::FONT_1px);
@@ -183,6 +206,8 @@ public:
 private:
   static bool disp_volume_overlay_;
   static bool disp_source_info_;
+  static bool enc_pressed_;
+  static bool enc_turned_;
 
   static void ShowVolumeOverlay()
   {
@@ -199,7 +224,7 @@ private:
   static void HideVolumeOverlay()
   {
     TimerSlots::Reset(TIMER_SLOT_VOL);
-    global_state.disp_brightness = VFD::kMinBrightness;
+    global_state.restore_brightness();
     disp_volume_overlay_ = false;
     volume_overlay.set_clear();
   }
@@ -225,6 +250,8 @@ private:
 
 bool MainMenu::disp_volume_overlay_ = false;
 bool MainMenu::disp_source_info_ = false;
+bool MainMenu::enc_pressed_ = false;
+bool MainMenu::enc_turned_ = false;
 
 MENU_IMPL(menu_main, MainMenu);
 
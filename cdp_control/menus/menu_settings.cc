@@ -148,7 +148,7 @@ using namespace ui;
 
   VFD::SetFont(VFD::FONT_MINI);
   VFD::SetGraphicCursor(0, 16);
-  VFD::PrintfP(PSTR("%d/%d"), current_setting_ + 1, SETTING_LAST);
+  VFD::Print(FMT_P("%d/%d"), current_setting_ + 1, SETTING_LAST);
 
   // This is all somewhat fragile but Just Fits
 
@@ -158,13 +158,13 @@ using namespace ui;
 
   VFD::SetFont(VFD::FONT_5x7);
   VFD::SetGraphicCursor(x + 4 + (w - strlen_P(current_setting_desc_->name) * 6 - 1) / 2, 9);
-  VFD::PrintfP(current_setting_desc_->name);
+  VFD::PrintP(current_setting_desc_->name);
 
   if (cursor_ < 0) VFD::SetArea(x, 0, w + 4, 11, 'O');
 
   x += w + 5;
   VFD::SetGraphicCursor(x, 9);
-  VFD::PrintfP(PSTR("\x1D"));
+  VFD::PrintP(PSTR("\x1D"));
 
   x += 6;
   auto value = Settings::get_value(static_cast<Setting>(current_setting_));
@@ -173,23 +173,23 @@ using namespace ui;
     if (strs) {
       auto str = avrx::pgm_read_pointer<const char *>(&strs[value]);
       VFD::SetGraphicCursor(x + 4 + (cw - 4 - strlen_P(str) * 6 - 1) / 2, 9);
-      VFD::PrintfP(str);
+      VFD::PrintP(str);
     } else {
       VFD::SetGraphicCursor(x + 4 + (cw - 4 - 3 * 6 - 1) / 2, 9);
-      VFD::PrintfP(PSTR("%3d"), value);
+      VFD::Print(FMT_P("%3d"), value);
     }
   } else {
     if (strs) {
       for (int8_t i = 0; i <= current_setting_desc_->max_value(); ++i) {
         auto str = avrx::pgm_read_pointer<const char *>(&strs[i]);
         VFD::SetGraphicCursor(x + 4 + (cw - 4 - strlen_P(str) * 6 - 1) / 2, 9);
-        VFD::PrintfP(str);
+        VFD::PrintP(str);
         if (cursor_ == i) VFD::SetArea(x, 0, cw, 11, 'O');
         x += cw;
       }
     } else {
       VFD::SetGraphicCursor(x + 4 + (cw - 4 - 3 * 6 - 1) / 2, 9);
-      VFD::PrintfP(PSTR("%3d"), cursor_);
+      VFD::Print(FMT_P("%3d"), cursor_);
       VFD::SetArea(x, 0, cw, 11, 'O');
     }
   }
@@ -19,18 +19,25 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 //
+#include <avr/io.h>
+
+#include "boot_stats.h"
 #include "cdp_control.h"
 #include "cdp_debug.h"
 #include "display.h"
 #include "drivers/vfd.h"
 #include "menus.h"
+#include "serial_console.h"
 #include "timer_slots.h"
 #include "ui/ui.h"
 #include "util/utils.h"
 
 namespace cdp {
 
-// 2240ms / 280 = 8ms per pixel
+// 2240ms / 280 = 8ms per pixel. After a watchdog or brown-out reset we'd rather be back in business
+// quickly, but still show the reset flags for a moment.
+static constexpr uint8_t kSplashMsPerPixel = 8;
+static constexpr uint8_t kSplashMsPerPixelFast = 2;
 
 using namespace ui;
 
@@ -39,21 +46,28 @@ public:
   static void Init() {}
   static void Enter()
   {
-    TimerSlots::Arm(TIMER_SLOT_MENU, 2240);
+    ms_per_pixel_ = debug_info.mcusr & (_BV(WDRF) | _BV(BORF)) ? kSplashMsPerPixelFast
+                                                                : kSplashMsPerPixel;
+    TimerSlots::Arm(TIMER_SLOT_MENU, VFD::kWidth * ms_per_pixel_);
     ticks_ = 0;
     global_state.disp_brightness = VFD::kMinBrightness;
   }
-  static void Exit() {}
+  static void Exit() { global_state.restore_brightness(); }
 
   static void Tick(uint16_t ticks)
   {
     ticks_ += ticks;
-    w_ = ticks_ / 8;
-    w_ = util::clamp(w_, 0U, 280U);
+    w_ = ticks_ / ms_per_pixel_;
+    w_ = util::clamp<uint16_t>(w_, 0, 280);
 
     if (TimerSlots::elapsed(TIMER_SLOT_MENU)) {
       TimerSlots::Reset(TIMER_SLOT_MENU);
       Menus::set_current(&menu_main);
+
+      BootStats::PhaseDone(BOOT_PHASE_UI);
+      const auto &boot_millis = debug_info.boot_millis;
+      SERIAL_TRACE_P("boot %u ms (init %u, display %u)", boot_millis[BOOT_PHASE_UI],
+                     boot_millis[BOOT_PHASE_CDPLAYER], boot_millis[BOOT_PHASE_DISPLAY]);
     }
   }
 
@@ -65,8 +79,8 @@ public:
     if (splash_text_.is_dirty()) {
       splash_text_.Draw();
       VFD::SetGraphicCursor(0, 16);
-      VFD::PrintfP(PSTR("CDP CONTROL " CDPFW_VERSION_STRING " [%02x %02x]"), debug_info.mcusr,
-                   debug_info.boot_flags);
+      VFD::Print(FMT_P("CDP CONTROL " CDPFW_VERSION_STRING " [%02x %02x]"), debug_info.mcusr,
+                 debug_info.boot_flags);
     }
 
     VFD::SetArea(0, 0, w_, 4, 'F');
@@ -76,10 +90,12 @@ private:
   static GraphicText<0, 6, 280, 10, VFD::FONT_5x7, 1> splash_text_;
   static uint16_t w_;
   static uint16_t ticks_;
+  static uint8_t ms_per_pixel_;
 };
 
 uint16_t SplashScreen::w_ = 0;
 uint16_t SplashScreen::ticks_ = 0;
+uint8_t SplashScreen::ms_per_pixel_ = kSplashMsPerPixel;
 GraphicText<0, 6, 280, 10, VFD::FONT_5x7, 1> SplashScreen::splash_text_;
 
 MENU_IMPL(menu_splash, SplashScreen);
@@ -0,0 +1,95 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "ram_monitor.h"
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "cdp_control.h"
+#include "cdp_debug.h"
+#include "cdpro2.h"
+#include "drivers/serial_port.h"
+#include "serial_console.h"
+#include "ui/ui.h"
+
+extern uint8_t _end;  // Provided via linker script
+
+namespace cdp {
+
+static inline uint16_t end_address()
+{
+  return reinterpret_cast<uintptr_t>(&_end);
+}
+
+// This is placed between the init sections and runs before .data/.bss are initialized (.init4) but
+// after the stack pointer is set up (.init2). It's never called, so it must be naked and can't use
+// the stack.
+extern "C" void PaintStack() __attribute__((naked, used, section(".init3")));
+void PaintStack()
+{
+  for (auto p = &_end; p <= reinterpret_cast<uint8_t *>(RAMEND); ++p) *p = RamMonitor::kPaint;
+}
+
+/*static*/ uint16_t RamMonitor::stack_margin()
+{
+  const uint8_t *p = &_end;
+  const uint8_t *sp = reinterpret_cast<const uint8_t *>(SP);
+  while (p < sp && kPaint == *p) ++p;
+  return p - &_end;
+}
+
+/*static*/ uint16_t RamMonitor::free_ram()
+{
+  return SP - end_address();
+}
+
+/*static*/ void RamMonitor::Check()
+{
+  if (stack_margin() < kStackMarginWarning) debug_info.boot_flags |= STACK_LOW;
+}
+
+static void PrintUsage(const char *name, util::RingBufferUsage usage)
+{
+  SerialConsole::Print(FMT_P("%-8S %3u/%3u"), name, usage.high_water, usage.size);
+}
+
+static bool PrintMemory(const util::CommandTokenizer::Tokens &)
+{
+  const uint16_t margin = RamMonitor::stack_margin();
+  const uint16_t max_stack = RAMEND + 1 - end_address() - margin;
+  SerialConsole::Print(FMT_P("stack    %4u max %4u margin%S"), max_stack, margin,
+                       margin < RamMonitor::kStackMarginWarning ? PSTR(" LOW") : PSTR(""));
+  SerialConsole::Print(FMT_P("free     %4u"), RamMonitor::free_ram());
+  SerialConsole::Print(FMT_P("scratch  %3u/%3u"), Scratch::high_water(), Scratch::kSize);
+  PrintUsage(PSTR("events"), ui::UI::event_queue_usage());
+  PrintUsage(PSTR("rx"), SerialPort::rx_usage());
+  PrintUsage(PSTR("tx"), SerialPort::tx_usage());
+  PrintUsage(PSTR("tx_queue"), SerialPort::tx_queue_usage());
+  PrintUsage(PSTR("actions"), CDPlayer::queued_actions_usage());
+#if defined(ENABLE_SERIAL_TRACE) && defined(ENABLE_DEFERRED_TRACE)
+  PrintUsage(PSTR("trace"), SerialTrace::usage());
+#endif
+  return true;
+}
+CCMD(mem, 0, PrintMemory);
+
+}  // namespace cdp
@@ -0,0 +1,50 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef RAM_MONITOR_H_
+#define RAM_MONITOR_H_
+
+#include <stdint.h>
+
+namespace cdp {
+
+// The free RAM between the end of .noinit (there's no heap) and the stack is painted at boot, so
+// the deepest the stack has ever reached can be found by looking for the first overwritten byte.
+// This includes ISRs (SysTick -> irmp_ISR, SPI etc.) since they run on the same stack.
+class RamMonitor {
+public:
+  static constexpr uint8_t kPaint = 0xc5;
+  static constexpr uint16_t kStackMarginWarning = 128;
+
+  // Still painted bytes above the end of .noinit, i.e. how close the stack got to the static data.
+  // NOTE This is a scan over up to ~1K so not for every loop.
+  static uint16_t stack_margin();
+
+  // Bytes between the end of .noinit and the current stack pointer
+  static uint16_t free_ram();
+
+  // Sets STACK_LOW in debug_info.boot_flags if the margin is below kStackMarginWarning
+  static void Check();
+};
+
+}  // namespace cdp
+
+#endif  // RAM_MONITOR_H_
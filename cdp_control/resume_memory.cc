@@ -0,0 +1,103 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "resume_memory.h"
+
+#include <avr/eeprom.h>
+#include <string.h>
+
+namespace cdp {
+
+static ResumeMemory::Record EEMEM eeprom_records[ResumeMemory::kNumRecords];
+
+/*static*/ uint16_t ResumeMemory::writes_ = 0;
+
+// Erased EEPROM reads as 0xff, which is never a valid title
+static inline bool empty(const ResumeMemory::Record &record)
+{
+  return !record.title || 0xff == record.title;
+}
+
+int8_t ResumeMemory::FindSlot(const uint8_t *disc_id, Record &record)
+{
+  for (uint8_t slot = 0; slot < kNumRecords; ++slot) {
+    eeprom_read_block(&record, &eeprom_records[slot], sizeof(Record));
+    if (!empty(record) && !memcmp(record.disc_id, disc_id, kDiscIdLength)) return slot;
+  }
+  return -1;
+}
+
+bool ResumeMemory::Find(const uint8_t *disc_id, Record &record)
+{
+  return FindSlot(disc_id, record) >= 0;
+}
+
+void ResumeMemory::Store(const Record &record)
+{
+  // Re-use the disc's slot, otherwise replace an empty or the oldest one
+  Record current;
+  uint8_t slot = 0;
+  uint16_t newest = 0;
+  uint16_t oldest = 0xffff;
+  int8_t found = -1;
+  for (uint8_t i = 0; i < kNumRecords; ++i) {
+    eeprom_read_block(&current, &eeprom_records[i], sizeof(Record));
+    if (empty(current)) {
+      if (oldest) {
+        oldest = 0;
+        slot = i;
+      }
+      continue;
+    }
+    if (current.generation > newest) newest = current.generation;
+    if (!memcmp(current.disc_id, record.disc_id, kDiscIdLength)) {
+      found = i;
+    } else if (current.generation < oldest) {
+      oldest = current.generation;
+      slot = i;
+    }
+  }
+
+  Record updated = record;
+  if (found >= 0) {
+    slot = found;
+    eeprom_read_block(&current, &eeprom_records[slot], sizeof(Record));
+    // Only bump the generation when the disc changes, otherwise it'd wear just like the time
+    updated.generation = current.generation == newest ? newest : newest + 1;
+  } else {
+    updated.generation = newest + 1;
+  }
+
+  eeprom_update_block(&updated, &eeprom_records[slot], sizeof(Record));
+  ++writes_;
+}
+
+void ResumeMemory::Forget(const uint8_t *disc_id)
+{
+  Record record;
+  auto slot = FindSlot(disc_id, record);
+  if (slot >= 0) {
+    eeprom_update_byte(&eeprom_records[slot].title, 0);
+    ++writes_;
+  }
+}
+
+}  // namespace cdp
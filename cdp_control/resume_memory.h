@@ -0,0 +1,63 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef RESUME_MEMORY_H_
+#define RESUME_MEMORY_H_
+
+#include <stdint.h>
+
+namespace cdp {
+
+// Remembers the last play position for a handful of discs in EEPROM.
+//
+// Discs are identified by their TOC (track range + total time) which we get for free when loading
+// the disc, instead of another GET_DISC_IDENTIFIERS round trip. Writes use eeprom_update_block so
+// only bytes that actually change are touched, and the caller is expected to only store on power
+// off/lid open or title changes.
+class ResumeMemory {
+public:
+  static constexpr uint8_t kDiscIdLength = 5;
+  static constexpr uint8_t kNumRecords = 8;
+
+  struct Record {
+    uint8_t disc_id[kDiscIdLength];
+    uint8_t title;
+    uint8_t msf[3];       // Absolute disc time, or 0:0:0 if unknown
+    uint16_t generation;  // Newest record wins when replacing
+
+    inline bool has_time() const { return msf[0] || msf[1] || msf[2]; }
+  };
+
+  static bool Find(const uint8_t *disc_id, Record &record);
+  static void Store(const Record &record);
+  static void Forget(const uint8_t *disc_id);
+
+  static inline uint16_t writes() { return writes_; }
+
+private:
+  static uint16_t writes_;
+
+  static int8_t FindSlot(const uint8_t *disc_id, Record &record);
+};
+
+}  // namespace cdp
+
+#endif  // RESUME_MEMORY_H_
@@ -23,24 +23,16 @@
 
 #include <avr/pgmspace.h>
 #include <ctype.h>
-#include <stdarg.h>
-#include <stdio.h>
+#include <stdlib.h>
 
 #include "cdp_control.h"
 #include "drivers/serial_port.h"
+#include "serial_protocol.h"
 #include "util/command_tokenizer.h"
 
-// Provided via linker script
-extern "C" const console::Variable __start_cvars;
-extern "C" const console::Variable __end_cvars;
-extern "C" const console::Command __start_ccmds;
-extern "C" const console::Command __end_ccmds;
-
 namespace cdp {
 
-static char rx_buffer[64];
 static util::LineBuffer<SerialConsole, 128> line_buffer;
-static char fmt_buffer[128];
 
 // TODO simplify this; maybe to_string(value)?
 
@@ -50,42 +42,51 @@ static void PrintCvar(const console::Variable *cvar)
 
   switch (cvar->value.type) {
     case console::CVAR_BOOL:
-      SerialConsole::PrintfP(PSTR("%S=%S%S"), cvar->name,
-                             cvar->value.read<console::CVAR_BOOL>() ? PSTR("true") : PSTR("false"),
-                             flags);
+      SerialConsole::Print(FMT_P("%S=%S%S"), cvar->name,
+                           cvar->value.read<console::CVAR_BOOL>() ? PSTR("true") : PSTR("false"),
+                           flags);
       break;
     case console::CVAR_U8:
-      SerialConsole::PrintfP(PSTR("%S=%02x%S"), cvar->name, cvar->value.read<console::CVAR_U8>(),
-                             flags);
+      SerialConsole::Print(FMT_P("%S=%02x%S"), cvar->name, cvar->value.read<console::CVAR_U8>(),
+                           flags);
       break;
     case console::CVAR_U16:
-      SerialConsole::PrintfP(PSTR("%S=%04%S"), cvar->name, cvar->value.read<console::CVAR_U8>(),
-                             flags);
+      SerialConsole::Print(FMT_P("%S=%04x%S"), cvar->name, cvar->value.read<console::CVAR_U16>(),
+                           flags);
       break;
     case console::CVAR_STR:
-      SerialConsole::PrintfP(PSTR("%S='%s'%S"), cvar->name, cvar->value.read<console::CVAR_STR>(),
-                             flags);
+      SerialConsole::Print(FMT_P("%S='%s'%S"), cvar->name, cvar->value.read<console::CVAR_STR>(),
+                           flags);
       break;
     case console::CVAR_NONE: break;
   }
 }
 
-static const console::Command *FindCCmd(const char *ccmd_name)
+// The tables are sorted by name at link time (see atmega328p.xn) so this is a plain binary search
+// over [first, last), i.e. ~4 comparisons for the current set.
+template <typename T> static const T *FindByName(const T *first, const T *last, const char *name)
 {
   // cppcheck-suppress comparePointers
-  FOREACH_CCMD (ccmd) {
-    if (!strcmp_P(ccmd_name, ccmd->name)) return ccmd;
+  while (first < last) {
+    auto mid = first + (last - first) / 2;
+    auto cmp = strcmp_P(name, mid->name);
+    if (!cmp) return mid;
+    if (cmp < 0)
+      last = mid;
+    else
+      first = mid + 1;
   }
   return nullptr;
 }
 
+static const console::Command *FindCCmd(const char *ccmd_name)
+{
+  return FindByName(&__start_ccmds, &__end_ccmds, ccmd_name);
+}
+
 static const console::Variable *FindCVar(const char *cvar_name)
 {
-  // cppcheck-suppress comparePointers
-  FOREACH_CVAR (cvar) {
-    if (!strcmp_P(cvar_name, cvar->name)) return cvar;
-  }
-  return nullptr;
+  return FindByName(&__start_cvars, &__end_cvars, cvar_name);
 }
 
 static bool ListVariables(const util::CommandTokenizer::Tokens &)
@@ -98,7 +99,10 @@ static bool ListVariables(const util::CommandTokenizer::Tokens &)
 static bool ListCommands(const util::CommandTokenizer::Tokens &)
 {
   // cppcheck-suppress comparePointers
-  FOREACH_CCMD (ccmd) { SerialConsole::PrintfP(PSTR("%S"), ccmd->name); }
+  FOREACH_CCMD (ccmd) {
+    SerialPort::WriteP(ccmd->name);
+    SerialPort::WriteP(PSTR(SERIAL_ENDL));
+  }
   return true;
 }
 
@@ -112,24 +116,122 @@ static bool GetCVar(const util::CommandTokenizer::Tokens &tokens)
   return false;
 }
 
+// NOTE The dirty flags of the variables are cleared by their owners at various points in the main
+// loop (or not at all) so we can't rely on them here; but comparing the last pushed value is just
+// as cheap.
+struct WatchSlot {
+  const console::Variable *cvar;
+  uint16_t value;
+  uint16_t interval;
+  uint16_t last_millis;
+  bool framed;
+  bool pending;
+};
+
+static WatchSlot watches[SerialConsole::kMaxWatches];
+static uint16_t watch_millis = 0;
+
+static void Push(const WatchSlot &watch)
+{
+  if (watch.framed)
+    SerialProtocol::Notify(watch.cvar);
+  else
+    PrintCvar(watch.cvar);
+}
+
+/*static*/ bool SerialConsole::Watch(const console::Variable *cvar, uint16_t interval, bool framed)
+{
+  if (!interval) {
+    Unwatch(cvar);
+    return true;
+  }
+  if (interval > kMaxWatchInterval || console::CVAR_STR == cvar->value.type) return false;
+
+  WatchSlot *slot = nullptr;
+  for (auto &watch : watches) {
+    if (watch.cvar == cvar) {
+      slot = &watch;
+      break;
+    }
+    if (!watch.cvar && !slot) slot = &watch;
+  }
+  if (!slot) return false;
+
+  *slot = {cvar, 0, interval, static_cast<uint16_t>(watch_millis - interval), framed, true};
+  return true;
+}
+
+/*static*/ void SerialConsole::Unwatch(const console::Variable *cvar)
+{
+  for (auto &watch : watches) {
+    if (!cvar || watch.cvar == cvar) watch.cvar = nullptr;
+  }
+}
+
+/*static*/ void SerialConsole::UpdateWatches(uint16_t millis)
+{
+  watch_millis = millis;
+  for (auto &watch : watches) {
+    if (!watch.cvar) continue;
+    auto value = watch.cvar->value.raw();
+    uint16_t elapsed = millis - watch.last_millis;
+    if ((watch.pending || value != watch.value) && elapsed >= watch.interval) {
+      watch.value = value;
+      watch.last_millis = millis;
+      watch.pending = false;
+      Push(watch);
+    }
+  }
+}
+
+static bool WatchCVar(const util::CommandTokenizer::Tokens &tokens)
+{
+  auto cvar = FindCVar(tokens[1]);
+  long interval = SerialConsole::kDefaultWatchInterval;
+  if (tokens.num_tokens > 2) {
+    char *end;
+    interval = strtol(tokens[2], &end, 10);
+    if (*end || interval < 0 || interval > SerialConsole::kMaxWatchInterval) return false;
+  }
+  return cvar && SerialConsole::Watch(cvar, interval, false);
+}
+
+static bool UnwatchCVar(const util::CommandTokenizer::Tokens &tokens)
+{
+  const console::Variable *cvar = nullptr;
+  if (tokens.num_tokens > 1) {
+    cvar = FindCVar(tokens[1]);
+    if (!cvar) return false;
+  }
+  SerialConsole::Unwatch(cvar);
+  return true;
+}
+
 CCMD(cmds, 0, ListCommands);
 CCMD(vars, 0, ListVariables);
 CCMD(get, 1, GetCVar);
+CCMD(watch, 1, WatchCVar);
+CCMD(unwatch, 0, UnwatchCVar);
 
-static void DispatchCommand(const util::CommandTokenizer::Tokens &tokens)
+static bool DispatchCommand(const util::CommandTokenizer::Tokens &tokens)
 {
-  if (!tokens.num_tokens) return;
-
   auto cmd = FindCCmd(tokens[0]);
 
   auto num_args = tokens.num_tokens - 1;
 
-  if (!cmd || num_args < cmd->min_args || !cmd->Invoke(tokens)) SerialConsole::PrintfP(PSTR("???"));
+  return cmd && num_args >= cmd->min_args && cmd->Invoke(tokens);
+}
+
+/*static*/ bool SerialConsole::Execute(char *line)
+{
+  auto tokens = util::CommandTokenizer::Tokenize(line);
+  return tokens.num_tokens && DispatchCommand(tokens);
 }
 
 void SerialConsole::Init()
 {
   line_buffer.Reset();
+  SerialProtocol::Reset();
 
   SerialPort::Init();
   SerialPort::WriteImmediateP(PSTR("\r\n****\r\n"));
@@ -138,39 +240,24 @@ void SerialConsole::Init()
 
 void SerialConsole::Poll()
 {
-  auto rx_len = SerialPort::Read(rx_buffer);
-  auto rx = rx_buffer;
-  while (rx_len--) {
-    auto c = *rx++;
+  // Consume directly from the rx ring, anything arriving meanwhile is handled in the same pass
+  while (SerialPort::readable()) {
+    auto c = SerialPort::Read();
+    if (SerialProtocol::Receive(c)) continue;
+
     switch (c) {
-      case '\n':
-        DispatchCommand(util::CommandTokenizer::Tokenize(line_buffer.mutable_str()));
+      case '\n': {
+        auto tokens = util::CommandTokenizer::Tokenize(line_buffer.mutable_str());
+        if (tokens.num_tokens && !DispatchCommand(tokens)) SerialConsole::Print(FMT_P("???"));
         line_buffer.Reset();
-        break;
+      } break;
       default: line_buffer.Push(c);
     }
   }
-}
 
-#if 0
-void SerialConsole::Printf(const char *fmt, ...)
-{
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(fmt_buffer, sizeof(fmt_buffer), fmt, args);
-  va_end(args);
-  SerialPort::Write(fmt_buffer);
-}
+#if defined(ENABLE_SERIAL_TRACE) && defined(ENABLE_DEFERRED_TRACE)
+  SerialTrace::Flush();
 #endif
-
-void SerialConsole::PrintfP(const char *fmt, ...)
-{
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf_P(fmt_buffer, sizeof(fmt_buffer), fmt, args);
-  va_end(args);
-  SerialPort::Write(fmt_buffer);
-  SerialPort::WriteP(PSTR("\r\n"));
 }
 
 }  // namespace cdp
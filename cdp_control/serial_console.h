@@ -25,6 +25,11 @@
 #include <avr/pgmspace.h>
 
 #include "console_types.h"
+#include "drivers/serial_port.h"
+#include "util/format.h"
+#ifdef ENABLE_DEFERRED_TRACE
+#include "serial_trace.h"
+#endif
 
 namespace cdp {
 
@@ -33,13 +38,48 @@ public:
   static void Init();
   static void Poll();
 
-  // static void Printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
-  static void PrintfP(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+  // Tokenize and run a command line, returns false if the command doesn't exist or failed.
+  // NOTE This modifies the line in place.
+  static bool Execute(char *line);
+
+  // Subscriptions push a variable when it changes, but at most every `interval` millis. Framed
+  // subscriptions are sent as SerialProtocol::MSG_CVAR_NOTIFY, otherwise as text. The current value
+  // is sent on the next update after subscribing. Strings can't be watched. An interval of 0
+  // unwatches the variable, both for the `watch` command and MSG_CVAR_WATCH.
+  static constexpr uint8_t kMaxWatches = 4;
+  static constexpr uint16_t kDefaultWatchInterval = 100;
+  static constexpr uint16_t kMaxWatchInterval = 10000;
+
+  static bool Watch(const console::Variable *cvar, uint16_t interval, bool framed);
+  static void Unwatch(const console::Variable *cvar);  // nullptr for all
+
+  // Call after all state has been updated, but before dirty flags are cleared
+  static void UpdateWatches(uint16_t millis);
+
+  // Print a line, e.g. Print(FMT_P("%S=%u"), name, value), \sa util/format.h
+  template <typename Fmt, typename... Args>
+  static util::if_format_t<Fmt> Print(Fmt fmt, Args... args);
 };
 
 #define SERIAL_ENDL "\r\n"
-#ifdef ENABLE_SERIAL_TRACE
-#define SERIAL_TRACE_P(...) SerialConsole::PrintfP(__VA_ARGS__)
+
+template <typename Fmt, typename... Args>
+/*static*/ util::if_format_t<Fmt> SerialConsole::Print(Fmt fmt, Args... args)
+{
+  SerialPort::Writer writer;
+  util::Format(writer, fmt, args...);
+  writer.PutP(PSTR(SERIAL_ENDL), 2);
+}
+
+// Traces take a format string literal, e.g. SERIAL_TRACE_P("CD: %S %u", ...).
+#if defined(ENABLE_SERIAL_TRACE) && defined(ENABLE_DEFERRED_TRACE)
+#define SERIAL_TRACE_P(fmt, ...)                                                      \
+  do {                                                                                \
+    static const char trace_fmt[] __attribute__((section(".trace_fmt"), used)) = fmt; \
+    SerialTrace::Log(trace_fmt, ##__VA_ARGS__);                                       \
+  } while (0)
+#elif defined(ENABLE_SERIAL_TRACE)
+#define SERIAL_TRACE_P(fmt, ...) SerialConsole::Print(FMT_P(fmt), ##__VA_ARGS__)
 #else
 #define SERIAL_TRACE_P(...) \
   do {                      \
@@ -0,0 +1,240 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "serial_protocol.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+
+#include "cdp_control.h"
+#include "drivers/serial_port.h"
+#include "serial_console.h"
+#include "util/cobs.h"
+
+namespace cdp {
+
+/*static*/ SerialProtocol::State SerialProtocol::state_ = SerialProtocol::STATE_TEXT;
+/*static*/ uint8_t SerialProtocol::length_ = 0;
+
+static uint8_t rx_frame[util::Cobs::EncodedLength(SerialProtocol::kMaxFrameLength)];
+static uint8_t response[SerialProtocol::kMaxFrameLength];
+static uint8_t response_length = 0;
+
+static uint8_t notify_seq = 0;
+
+static util::Variable<uint8_t> frame_errors{0};
+CVAR_RO(frm_err, &frame_errors);
+
+static inline uint8_t num_cvars()
+{
+  return &__end_cvars - &__start_cvars;
+}
+
+static inline uint8_t num_ccmds()
+{
+  return &__end_ccmds - &__start_ccmds;
+}
+
+// Leave room for the crc; anything that doesn't fit is silently truncated, which only affects
+// strings.
+static inline void Put(uint8_t value)
+{
+  if (response_length < SerialProtocol::kMaxFrameLength - 1) response[response_length++] = value;
+}
+
+/*static*/ void SerialProtocol::Send(uint8_t *frame, uint8_t length)
+{
+  Scratch::Frame scratch;
+  auto tx_frame = scratch.Alloc<uint8_t>(util::Cobs::EncodedLength(kMaxFrameLength) + 2);
+  if (!tx_frame) return;
+
+  frame[length] = util::Crc8(frame, length);
+  auto encoded_length = util::Cobs::Encode(frame, length + 1, tx_frame + 1);
+  tx_frame[0] = tx_frame[encoded_length + 1] = 0;
+  SerialPort::Write(tx_frame, encoded_length + 2);
+}
+
+static inline void SendResponse()
+{
+  SerialProtocol::Send(response, response_length);
+}
+
+static uint8_t GetCVar(const console::Variable *cvar)
+{
+  console::CVAR_TYPE type = cvar->value.type;
+  Put(type);
+  switch (type) {
+    case console::CVAR_BOOL: Put(cvar->value.read<console::CVAR_BOOL>()); break;
+    case console::CVAR_U8: Put(cvar->value.read<console::CVAR_U8>()); break;
+    case console::CVAR_U16: {
+      uint16_t value = cvar->value.read<console::CVAR_U16>();
+      Put(value);
+      Put(value >> 8);
+    } break;
+    case console::CVAR_STR: {
+      auto str = cvar->value.read<console::CVAR_STR>();
+      while (*str) Put(*str++);
+    } break;
+    case console::CVAR_NONE: break;
+  }
+  return SerialProtocol::STATUS_OK;
+}
+
+static uint8_t SetCVar(const console::Variable *cvar, const uint8_t *value, uint8_t length)
+{
+  if (cvar->readonly()) return SerialProtocol::STATUS_READONLY;
+
+  switch (cvar->value.type) {
+    case console::CVAR_BOOL:
+      if (length != 1) break;
+      cvar->value.write<console::CVAR_BOOL>(!!value[0]);
+      return SerialProtocol::STATUS_OK;
+    case console::CVAR_U8:
+      if (length != 1) break;
+      cvar->value.write<console::CVAR_U8>(value[0]);
+      return SerialProtocol::STATUS_OK;
+    case console::CVAR_U16:
+      if (length != 2) break;
+      cvar->value.write<console::CVAR_U16>(static_cast<uint16_t>(value[0] | (value[1] << 8)));
+      return SerialProtocol::STATUS_OK;
+    case console::CVAR_STR:
+    case console::CVAR_NONE: return SerialProtocol::STATUS_READONLY;
+  }
+  return SerialProtocol::STATUS_INVALID_LENGTH;
+}
+
+/*static*/ void SerialProtocol::Notify(const console::Variable *cvar)
+{
+  response_length = 0;
+  Put(notify_seq++);
+  Put(MSG_CVAR_NOTIFY);
+  Put(cvar - &__start_cvars);
+  GetCVar(cvar);
+  SendResponse();
+}
+
+/*static*/ void SerialProtocol::Reset()
+{
+  state_ = STATE_TEXT;
+  length_ = 0;
+}
+
+/*static*/ bool SerialProtocol::Receive(uint8_t c)
+{
+  if (!c) {
+    // An empty frame (i.e. two consecutive delimiters) just (re-)starts a frame
+    if (STATE_TEXT == state_ || !length_) {
+      state_ = STATE_FRAME;
+    } else {
+      if (STATE_FRAME == state_) {
+        auto length = util::Cobs::Decode(rx_frame, length_);
+        if (length > 2 && !util::Crc8(rx_frame, length))
+          Dispatch(rx_frame, length - 1);
+        else
+          frame_errors.set(frame_errors + 1);
+      }
+      state_ = STATE_TEXT;
+    }
+    length_ = 0;
+    return true;
+  }
+
+  switch (state_) {
+    case STATE_TEXT: return false;
+    case STATE_FRAME:
+      if (length_ < sizeof(rx_frame)) {
+        rx_frame[length_++] = c;
+      } else {
+        frame_errors.set(frame_errors + 1);
+        state_ = STATE_DISCARD;
+      }
+      break;
+    case STATE_DISCARD: break;
+  }
+  return true;
+}
+
+/*static*/ void SerialProtocol::Dispatch(uint8_t *request, uint8_t length)
+{
+  const uint8_t type = request[1];
+  uint8_t *payload = request + 2;
+  const uint8_t payload_length = length - 2;
+
+  response_length = 0;
+  Put(request[0]);
+  Put(type | MSG_RESPONSE);
+  Put(STATUS_OK);
+
+  uint8_t status = STATUS_OK;
+  switch (type) {
+    case MSG_PING:
+      Put(kVersion);
+      Put(num_cvars());
+      Put(num_ccmds());
+      break;
+    case MSG_CVAR_INFO:
+    case MSG_CVAR_GET:
+    case MSG_CVAR_SET: {
+      if (payload_length < 1) {
+        status = STATUS_INVALID_LENGTH;
+        break;
+      }
+      if (payload[0] >= num_cvars()) {
+        status = STATUS_INVALID_INDEX;
+        break;
+      }
+      auto cvar = &__start_cvars + payload[0];
+      if (MSG_CVAR_INFO == type) {
+        Put(cvar->value.type);
+        Put(cvar->flags);
+        auto name = cvar->name;
+        for (auto c = pgm_read_byte(name); c; c = pgm_read_byte(++name)) Put(c);
+      } else if (MSG_CVAR_GET == type) {
+        status = GetCVar(cvar);
+      } else {
+        status = SetCVar(cvar, payload + 1, payload_length - 1);
+      }
+    } break;
+    case MSG_CVAR_WATCH:
+      if (payload_length != 3) {
+        status = STATUS_INVALID_LENGTH;
+      } else if (payload[0] >= num_cvars()) {
+        status = STATUS_INVALID_INDEX;
+      } else {
+        auto cvar = &__start_cvars + payload[0];
+        uint16_t interval = payload[1] | (payload[2] << 8);
+        if (!SerialConsole::Watch(cvar, interval, true)) status = STATUS_FAILED;
+      }
+      break;
+    case MSG_COMMAND:
+      // The crc has been stripped so there's room to terminate the string
+      payload[payload_length] = 0;
+      if (!SerialConsole::Execute(reinterpret_cast<char *>(payload))) status = STATUS_FAILED;
+      break;
+    default: status = STATUS_UNKNOWN_TYPE;
+  }
+
+  if (STATUS_OK != status) response_length = 3;
+  response[2] = status;
+  SendResponse();
+}
+
+}  // namespace cdp
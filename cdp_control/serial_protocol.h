@@ -0,0 +1,101 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef SERIAL_PROTOCOL_H_
+#define SERIAL_PROTOCOL_H_
+
+#include <stdint.h>
+
+#include "console_types.h"
+
+namespace cdp {
+
+// Binary protocol for a host (e.g. the media player) that shares the serial port with the text
+// console. This saves both sides from formatting and parsing printf output.
+//
+// Frames are COBS encoded and delimited by 0x00 on both ends, i.e. 00 <cobs> 00. The text console
+// never uses 0x00, so anything between a pair of delimiters is a frame and everything else is
+// text. The host can use the same rule to separate responses from console output (e.g. the output
+// of MSG_COMMAND, or traces).
+//
+// Decoded request:  seq | type | payload... | crc8
+// Decoded response: seq | type | MSG_RESPONSE | status | payload... | crc8
+//
+// The crc8 (see util/cobs.h) covers all preceeding bytes. The sequence number is chosen by the
+// host and echoed so responses can be matched to requests. Frames with an invalid CRC are dropped
+// (and counted in `frm_err`) since there's no reliable seq to respond to.
+//
+// Watched variables are pushed as: seq | MSG_CVAR_NOTIFY | index | type | value... | crc8
+// with a sequence number counted by the device, so the host can detect dropped updates.
+// Deferred traces (see serial_trace.h) are sent as: seq | MSG_TRACE | id (u16) | args... | crc8
+// or as MSG_TRACE_TRUNCATED if the arguments didn't fit.
+//
+// Variables are addressed by their index in the (sorted) .cvars table, which is stable for a given
+// build; MSG_CVAR_INFO can be used to enumerate them. Multi-byte values are little-endian.
+class SerialProtocol {
+public:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr uint8_t kMaxFrameLength = 40;  // Decoded, including header and crc
+
+  enum MessageType : uint8_t {
+    MSG_PING = 0x01,       // -> version, num_cvars, num_ccmds
+    MSG_CVAR_INFO = 0x02,  // index -> type, flags, name
+    MSG_CVAR_GET = 0x03,   // index -> type, value
+    MSG_CVAR_SET = 0x04,   // index, value ->
+    MSG_COMMAND = 0x05,    // command line -> (output is text)
+    MSG_CVAR_WATCH = 0x06, // index, interval (u16, 0 to unwatch, \sa SerialConsole::Watch) ->
+    MSG_CVAR_NOTIFY = 0x40,
+    MSG_TRACE = 0x41,
+    MSG_TRACE_TRUNCATED = 0x42,
+    MSG_RESPONSE = 0x80,
+  };
+
+  enum Status : uint8_t {
+    STATUS_OK,
+    STATUS_UNKNOWN_TYPE,
+    STATUS_INVALID_INDEX,
+    STATUS_INVALID_LENGTH,
+    STATUS_READONLY,
+    STATUS_FAILED,
+  };
+
+  static void Reset();
+
+  // Returns true if the byte was consumed as part of a frame, otherwise it's text.
+  static bool Receive(uint8_t c);
+
+  static void Notify(const console::Variable *cvar);
+
+  // Add crc and send; `frame` must have room for one more byte.
+  static void Send(uint8_t *frame, uint8_t length);
+
+private:
+  enum State : uint8_t { STATE_TEXT, STATE_FRAME, STATE_DISCARD };
+
+  static State state_;
+  static uint8_t length_;
+
+  static void Dispatch(uint8_t *request, uint8_t length);
+};
+
+}  // namespace cdp
+
+#endif  // SERIAL_PROTOCOL_H_
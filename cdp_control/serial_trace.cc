@@ -0,0 +1,54 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "serial_trace.h"
+
+namespace cdp {
+
+/*static*/ uint8_t SerialTrace::seq_ = 0;
+
+void SerialTrace::Record::Pack(char *str)
+{
+  if (truncated()) return;
+  if (length_ >= kMaxRecordLength) {
+    Truncate();
+    return;
+  }
+  while (*str && length_ < kMaxRecordLength - 1) Put(*str++);
+  if (*str) Truncate();
+  Put(0);
+}
+
+/*static*/ void SerialTrace::Flush()
+{
+  while (records_::readable()) {
+    Scratch::Frame scratch;
+    auto frame = scratch.Alloc<uint8_t>(SerialProtocol::kMaxFrameLength);  // seq + record + crc
+    if (!frame) return;
+
+    const uint8_t length = records_::Pop();
+    frame[0] = seq_++;
+    for (uint8_t i = 1; i <= length; ++i) frame[i] = records_::Pop();
+    SerialProtocol::Send(frame, length + 1);
+  }
+}
+
+}  // namespace cdp
@@ -0,0 +1,150 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef SERIAL_TRACE_H_
+#define SERIAL_TRACE_H_
+
+#include <stdint.h>
+
+#include "cdp_control.h"
+#include "serial_protocol.h"
+#include "util/ring_buffer.h"
+
+namespace cdp {
+
+// Deferred traces (ENABLE_DEFERRED_TRACE)
+//
+// Instead of formatting on the MCU, the format string of each SERIAL_TRACE_P call site is placed
+// in the .trace_fmt section which isn't loaded into flash, and its address is the trace id. Only
+// the id and the raw arguments are sent (as SerialProtocol::MSG_TRACE frames), and
+// host/trace_decode.py uses the ELF to turn them back into text.
+//
+// Arguments are packed by type, mimicking the vararg promotions on AVR:
+// - integers up to 16 bits (%d, %u, %x, %c) as 16 bits, 32 bit integers (%l...) as 32 bits.
+// - `const char *` (%S) as 16 bit flash address, the string is read from the ELF.
+// - `char *` (%s) is copied including the terminating zero.
+// NOTE This means a RAM string has to be passed as non-const.
+//
+// If the arguments don't fit into a record they're truncated (a string is cut short but still
+// terminated) and the record is sent as MSG_TRACE_TRUNCATED.
+class SerialTrace {
+public:
+  // A queued record is type | id (u16) | args..., the sequence number and crc are added when it's
+  // framed.
+  static constexpr uint8_t kMaxRecordLength = SerialProtocol::kMaxFrameLength - 2;
+
+  // The call site only packs the id and the raw arguments into a ring, the framing (crc + COBS)
+  // happens in Flush from the main loop (\sa SerialConsole::Poll). If there isn't room for the
+  // record the ring is flushed first, so nothing is dropped.
+  template <typename... Args> static void Log(const char *id, Args... args)
+  {
+    constexpr unsigned length = 3 + (0 + ... + Packed<Args>::kLength);
+    if (records_::writable() <= (length < kMaxRecordLength ? length : kMaxRecordLength)) Flush();
+
+    Record record{id};
+    (record.Pack(args), ...);
+  }
+
+  // Frame and send the queued records
+  static void Flush();
+
+  // Drop the queued records, for the microbenchmarks
+  static inline void Discard() { records_::Clear(); }
+
+  static inline util::RingBufferUsage usage() { return records_::usage(); }
+
+private:
+  // Records are prefixed with their length
+  using records_ = util::RingBuffer<SerialTrace, uint8_t, 64>;
+  static_assert(kMaxRecordLength < records_::kSize);
+
+  static uint8_t seq_;
+
+  // Worst case packed length of an argument
+  template <typename T> struct Packed {
+    static constexpr uint8_t kLength = sizeof(T) <= 2 ? 2 : 4;
+  };
+
+  class Record {
+  public:
+    explicit Record(const char *id) : length_(records_::Head())
+    {
+      records_::Push();
+      length_ = 0;
+      type_ = &records_::Head();
+      uint16_t addr = reinterpret_cast<uintptr_t>(id);
+      Put(SerialProtocol::MSG_TRACE);
+      Put(addr);
+      Put(addr >> 8);
+    }
+
+    template <typename T> inline void Pack(T value)
+    {
+      static_assert(sizeof(T) <= 4, "Unsupported trace argument");
+      if (truncated()) return;
+      if (length_ + Packed<T>::kLength > kMaxRecordLength) {
+        Truncate();
+        return;
+      }
+      if constexpr (sizeof(T) <= 2) {
+        uint16_t v = value;
+        Put(v);
+        Put(v >> 8);
+      } else {
+        uint32_t v = value;
+        Put(v);
+        Put(v >> 8);
+        Put(v >> 16);
+        Put(v >> 24);
+      }
+    }
+
+    inline void Pack(const char *pstr) { Pack<uint16_t>(reinterpret_cast<uintptr_t>(pstr)); }
+
+    void Pack(char *str);
+
+  private:
+    uint8_t &length_;
+    uint8_t *type_;
+
+    inline void Put(uint8_t value)
+    {
+      records_::Push(value);
+      ++length_;
+    }
+
+    // Arguments that don't fit are dropped, along with any that follow
+    inline bool truncated() const { return SerialProtocol::MSG_TRACE_TRUNCATED == *type_; }
+    inline void Truncate() { *type_ = SerialProtocol::MSG_TRACE_TRUNCATED; }
+  };
+};
+
+template <> struct SerialTrace::Packed<const char *> {
+  static constexpr uint8_t kLength = 2;
+};
+
+template <> struct SerialTrace::Packed<char *> {
+  static constexpr uint8_t kLength = kMaxRecordLength;
+};
+
+}  // namespace cdp
+
+#endif  // SERIAL_TRACE_H_
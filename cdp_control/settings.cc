@@ -25,6 +25,7 @@
 
 #include "avrx/macros.h"
 #include "cover_sensor.h"
+#include "topics.h"
 
 namespace cdp {
 
@@ -47,7 +48,38 @@ int8_t Settings::values_[SETTING_LAST] = {0};
 
 /*static*/ void Settings::InitDefaults()
 {
+  values_[SETTING_DIG_OUT] = DIG_OUT_SRC;  // \sa SRC4392::Init
   values_[SETTING_SENSOR_THRESHOLD] = CoverSensor::kOpenThreshold;
 }
 
+/*static*/ void Settings::PublishAll()
+{
+  for (uint8_t setting = 0; setting < SETTING_LAST; ++setting)
+    Publish(static_cast<Setting>(setting));
+}
+
+/*static*/ bool Settings::apply_value(Setting setting, int8_t value)
+{
+  value = setting_desc_[setting].clamp(value);
+  if (value != values_[setting]) {
+    values_[setting] = value;
+    Publish(setting);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+/*static*/ void Settings::Publish(Setting setting)
+{
+  const auto value = values_[setting];
+  switch (setting) {
+    case SETTING_INPUT: SettingTopic<SETTING_INPUT>::Notify(value); break;
+    case SETTING_FILTER: SettingTopic<SETTING_FILTER>::Notify(value); break;
+    case SETTING_DIG_OUT: SettingTopic<SETTING_DIG_OUT>::Notify(value); break;
+    case SETTING_SENSOR_THRESHOLD: SettingTopic<SETTING_SENSOR_THRESHOLD>::Notify(value); break;
+    case SETTING_LAST: break;
+  }
+}
+
 }  // namespace cdp
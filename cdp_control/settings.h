@@ -39,6 +39,15 @@ enum Setting : uint8_t {
   SETTING_LAST,
 };
 
+// SETTING_INPUT is 0 = INT (i.e. the CD-Pro2 via I2S) or 1..4 = receiver inputs RX1..RX4.
+
+// SETTING_DIG_OUT, i.e. what the transmitter sends
+enum DigitalOutput : int8_t {
+  DIG_OUT_OFF,
+  DIG_OUT_BYPASS,
+  DIG_OUT_SRC,
+};
+
 // These are intended for PROGMEM use
 struct ProgmemSettingDesc {
   const char name[8];
@@ -61,6 +70,9 @@ class Settings {
 public:
   static void InitDefaults();
 
+  // Publish all values to their subscribers (\sa topics.h), i.e. make the hardware match
+  static void PublishAll();
+
   static int8_t get_value(Setting setting) { return values_[setting]; }
 
   static const ProgmemSettingDesc *GetDesc_P(int8_t index) { return &setting_desc_[index]; }
@@ -76,19 +88,13 @@ private:
   // These are stored in PROGMEM
   static const ProgmemSettingDesc setting_desc_[SETTING_LAST];
 
-  // Clamp and apply value; return true if changed
-  static bool apply_value(Setting setting, int8_t value)
-  {
-    value = setting_desc_[setting].clamp(value);
-    if (value != values_[setting]) {
-      values_[setting] = value;
-      return true;
-    } else {
-      return false;
-    }
-  }
+  // Clamp and apply value, and publish it if changed; return true if changed
+  static bool apply_value(Setting setting, int8_t value);
+
+  static void Publish(Setting setting);
 
   friend class SettingsMenu;
+  friend class SettingsStore;
 };
 
 }  // namespace cdp
@@ -0,0 +1,125 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#include "settings_store.h"
+
+#include <avr/eeprom.h>
+#include <string.h>
+
+#include "cdp_control.h"
+#include "resume_memory.h"
+#include "serial_console.h"
+#include "timer_slots.h"
+#include "util/cobs.h"
+
+namespace cdp {
+
+static SettingsStore::Record EEMEM eeprom_log[SettingsStore::kNumRecords];
+
+/*static*/ uint16_t SettingsStore::sequence_ = 0;
+/*static*/ uint8_t SettingsStore::newest_slot_ = SettingsStore::kNoRecord;
+/*static*/ uint16_t SettingsStore::writes_ = 0;
+
+static uint8_t crc(const SettingsStore::Record &record)
+{
+  return util::Crc8(reinterpret_cast<const uint8_t *>(&record), sizeof(record) - 1);
+}
+
+// Erased EEPROM reads as 0xff, which fails both checks
+static inline bool valid(const SettingsStore::Record &record)
+{
+  return SettingsStore::kVersion == record.version && crc(record) == record.crc;
+}
+
+static inline void Read(SettingsStore::Record &record, uint8_t slot)
+{
+  eeprom_read_block(&record, &eeprom_log[slot], sizeof(record));
+}
+
+/*static*/ bool SettingsStore::Restore()
+{
+  // The sequence numbers are consecutive, so comparing them as differences also works when they
+  // wrap around.
+  Record record;
+  for (uint8_t slot = 0; slot < kNumRecords; ++slot) {
+    Read(record, slot);
+    if (!valid(record)) continue;
+    if (kNoRecord == newest_slot_ || static_cast<int16_t>(record.sequence - sequence_) > 0) {
+      newest_slot_ = slot;
+      sequence_ = record.sequence;
+    }
+  }
+  if (kNoRecord == newest_slot_) return false;
+
+  Read(record, newest_slot_);
+  const auto &payload = record.payload;
+  for (uint8_t i = 0; i < SETTING_LAST; ++i)
+    Settings::values_[i] = Settings::setting_desc_[i].clamp(payload.settings[i]);
+  global_state.src4392.attenuation = payload.attenuation;
+  global_state.user_brightness = payload.user_brightness & 0x3;
+
+  TimerSlots::Reset(TIMER_SLOT_SETTINGS_STORE);
+  return true;
+}
+
+/*static*/ void SettingsStore::Save()
+{
+  Record record;
+  auto &payload = record.payload;
+  memcpy(payload.settings, Settings::values_, sizeof(payload.settings));
+  payload.attenuation = global_state.src4392.attenuation;
+  payload.user_brightness = global_state.user_brightness;
+
+  uint8_t slot = 0;
+  if (kNoRecord != newest_slot_) {
+    Record current;
+    Read(current, newest_slot_);
+    if (!memcmp(&current.payload, &payload, sizeof(Payload))) return;
+    slot = newest_slot_ + 1 < kNumRecords ? newest_slot_ + 1 : 0;
+  }
+
+  record.sequence = sequence_ + 1;
+  record.version = kVersion;
+  record.crc = crc(record);
+  eeprom_update_block(&record, &eeprom_log[slot], sizeof(record));
+
+  newest_slot_ = slot;
+  sequence_ = record.sequence;
+  ++writes_;
+}
+
+/*static*/ void SettingsStore::Schedule()
+{
+  TimerSlots::Arm(TIMER_SLOT_SETTINGS_STORE, kSettingsStoreDelayMs);
+}
+
+static bool PrintEeprom(const util::CommandTokenizer::Tokens &)
+{
+  // The sequence counts all saves ever, so the wear per slot is roughly sequence / kNumRecords
+  SerialConsole::Print(FMT_P("settings seq %5u slot %2u writes %u"), SettingsStore::sequence(),
+                       SettingsStore::newest_slot(), SettingsStore::writes());
+  SerialConsole::Print(FMT_P("resume   writes %u"), ResumeMemory::writes());
+  return true;
+}
+
+CCMD(eeprom, 0, PrintEeprom);
+
+}  // namespace cdp
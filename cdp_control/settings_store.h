@@ -0,0 +1,83 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef SETTINGS_STORE_H_
+#define SETTINGS_STORE_H_
+
+#include <stdint.h>
+
+#include "settings.h"
+
+namespace cdp {
+
+// Keeps the settings (and a few bits of global state) in EEPROM.
+//
+// Each save appends a record to a small log instead of overwriting the same cells, so the wear is
+// spread over kNumRecords slots. Records have a sequence number and a CRC; at boot the newest
+// valid record wins, so a write that's interrupted by a power cut just falls back to the previous
+// one. Changes are published (\sa topics.h) and only saved after kSettingsStoreDelayMs without
+// further changes, so turning the encoder results in a single write. A save that wouldn't change
+// anything is skipped.
+//
+// NOTE eeprom_update_block is blocking, i.e. a save takes ~3.4ms per changed byte.
+class SettingsStore {
+public:
+  static constexpr uint8_t kNumRecords = 32;
+  static constexpr uint8_t kVersion = 1;  // Bump when the Payload changes
+
+  struct Payload {
+    int8_t settings[SETTING_LAST];
+    uint8_t attenuation;
+    uint8_t user_brightness;
+  };
+
+  struct Record {
+    uint16_t sequence;
+    uint8_t version;
+    Payload payload;
+    uint8_t crc;  // Over all preceding bytes
+  };
+
+  // Find the newest valid record and apply it, if there is one
+  static bool Restore();
+
+  static void Save();
+
+  // Subscriber for anything that's stored, \sa topics.h
+  template <typename T> static void Changed(T) { Schedule(); }
+
+  static inline uint16_t sequence() { return sequence_; }
+  static inline uint8_t newest_slot() { return newest_slot_; }
+  static inline uint16_t writes() { return writes_; }
+
+private:
+  static constexpr uint8_t kNoRecord = 0xff;
+
+  static uint16_t sequence_;
+  static uint8_t newest_slot_;
+  static uint16_t writes_;
+
+  static void Schedule();
+};
+
+}  // namespace cdp
+
+#endif  // SETTINGS_STORE_H_
@@ -26,6 +26,7 @@
 
 #include "cdp_debug.h"
 #include "serial_console.h"
+#include "settings.h"
 #include "src_state.h"
 
 namespace cdp {
@@ -77,7 +78,7 @@ bool SRC4392::Init()
 
   debug_info.src_init = success;
   if (success != num_registers) {
-    SERIAL_TRACE_P(PSTR("SRC4392::Init failure: %d\r\n"), success);
+    SERIAL_TRACE_P("SRC4392::Init failure: %d\r\n", success);
     return false;
   } else {
     return true;
@@ -95,6 +96,32 @@ void SRC4392::Update(const SRCState &state)
   }
 }
 
+// RECEIVER_CONTROL
+// 0x08 = [RXCLK = MCLK][RXMUX = b00-b11 = RX1-RX4]
+// The SRC input itself follows the source (\sa ApplyInput), INT doesn't need the receiver.
+void SRC4392::SelectReceiver(int8_t input)
+{
+  if (debug_info.src_init && input) Write<RECEIVER_CONTROL>(0x08 | ((input - 1) & 0x03));
+}
+
+void SRC4392::SelectFilter(int8_t filter)
+{
+  if (debug_info.src_init) Write<GPO1>(filter ? 0x01 : 0x00);  // \sa Init
+}
+
+// TRANSMITTER_CONTROL
+// 0x38 = [TXCLK=MCLK, TXDIV=256, TXIS = b11 = SRC], 0x18 = TXIS = b01 = PORTB, i.e. no SRC
+// 0x07 = [...][TXMUTE=1, TXOFF=1]
+void SRC4392::SelectOutput(int8_t output)
+{
+  if (!debug_info.src_init) return;
+  switch (output) {
+    case DIG_OUT_BYPASS: Write<TRANSMITTER_CONTROL>(0x18, 0x00); break;
+    case DIG_OUT_SRC: Write<TRANSMITTER_CONTROL>(0x38, 0x00); break;
+    default: Write<TRANSMITTER_CONTROL>(0x38, 0x07); break;
+  }
+}
+
 // \sa menu_main.cc:RatioToString
 // In order to properly read back the ratio, these registers must be read back in sequence, starting
 // with register 0x32.
@@ -65,6 +65,11 @@ public:
 
   static void Update(const SRCState &state);
 
+  // Setting subscribers, \sa topics.h
+  static void SelectReceiver(int8_t input);
+  static void SelectFilter(int8_t filter);
+  static void SelectOutput(int8_t output);
+
   static uint16_t ReadRatio();
 
 private:
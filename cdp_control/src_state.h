@@ -24,28 +24,40 @@
 
 #include <stdint.h>
 
+#include "topics.h"
 #include "util/utils.h"
 
 namespace cdp {
 
 enum Source : uint8_t {
   SOURCE_I2S = 0x1,  // PORTB
+  SOURCE_DIR = 0x2,  // Receiver, \sa SRC4392::SelectReceiver
 };
 
 struct SRCState {
-  util::Variable<Source> source{SOURCE_I2S};
-  util::Variable<bool> mute{true};
-  util::Variable<uint8_t> attenuation{0xff};
-  util::Variable<int8_t> filter{0};
+  using Dirty = util::DirtyMask<SRCState>;
+  enum DirtyBits : uint8_t {
+    DIRTY_SOURCE = 0x01,
+    DIRTY_MUTE = 0x02,
+    DIRTY_ATTENUATION = 0x04,
+    DIRTY_FILTER = 0x08,
+    DIRTY_RATIO = 0x10,
+    DIRTY_ALL = 0x1f,
+    DIRTY_SRC_CONTROL = DIRTY_SOURCE | DIRTY_MUTE | DIRTY_ATTENUATION,  // \sa SRC4392::Update
+  };
 
-  util::Variable<uint16_t> ratio{0xffff};
+  util::GroupVariable<Dirty, Source, DIRTY_SOURCE> source{SOURCE_I2S};
+  util::GroupVariable<Dirty, bool, DIRTY_MUTE, MuteTopic> mute{true};
+  util::GroupVariable<Dirty, uint8_t, DIRTY_ATTENUATION, AttenuationTopic> attenuation{0xff};
+  util::GroupVariable<Dirty, int8_t, DIRTY_FILTER> filter{0};
 
-  inline void clear_dirty()
-  {
-    util::ClearDirtyVariables(mute, attenuation, source, /*ratio,*/ filter);
-  }
+  util::GroupVariable<Dirty, uint16_t, DIRTY_RATIO> ratio{0xffff};
 
-  inline void force_dirty() { util::ForceDirtyVariables(mute, attenuation, source, ratio, filter); }
+  static inline bool dirty(uint8_t bits) { return Dirty::test(bits); }
+
+  // The ratio is cleared by its consumer (\sa menu_main.cc)
+  static inline void clear_dirty() { Dirty::clear(DIRTY_ALL & ~DIRTY_RATIO); }
+  static inline void force_dirty() { Dirty::set(DIRTY_ALL); }
 
   void toggle_mute() { mute.set(!mute.get()); }
 };
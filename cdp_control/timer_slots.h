@@ -39,6 +39,11 @@ enum TIMER_SLOT : uint8_t {
   TIMER_SLOT_MENU,
   TIMER_SLOT_CD_ERROR,
   TIMER_SLOT_CD_POWER,
+  TIMER_SLOT_CD_ENTRY,
+  TIMER_SLOT_CD_SCAN,
+  TIMER_SLOT_RAM_CHECK,
+  TIMER_SLOT_SETTINGS_STORE,
+  TIMER_SLOT_VFD_INIT,
   TIMER_SLOT_LAST,
 };
 
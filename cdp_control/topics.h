@@ -0,0 +1,68 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef TOPICS_H_
+#define TOPICS_H_
+
+#include <stdint.h>
+
+#include "cover_sensor.h"
+#include "settings.h"
+#include "settings_store.h"
+#include "src4392.h"
+#include "util/pubsub.h"
+
+// Who gets told about what (\sa util/pubsub.h). Settings are published when they are applied, state
+// variables when they are set; both also publish once at init so the hardware matches.
+
+namespace cdp {
+
+// cdp_control.cc
+void ApplyInput(int8_t input);
+void ApplyMute(bool mute);
+void ApplyBrightness(uint8_t brightness);
+
+// \sa Settings::apply_value
+template <Setting setting> struct SettingTopic;
+
+template <>
+struct SettingTopic<SETTING_INPUT>
+    : util::Subscribers<int8_t, &SRC4392::SelectReceiver, &ApplyInput,
+                        &SettingsStore::Changed<int8_t>> {};
+template <>
+struct SettingTopic<SETTING_FILTER>
+    : util::Subscribers<int8_t, &SRC4392::SelectFilter, &SettingsStore::Changed<int8_t>> {};
+template <>
+struct SettingTopic<SETTING_DIG_OUT>
+    : util::Subscribers<int8_t, &SRC4392::SelectOutput, &SettingsStore::Changed<int8_t>> {};
+template <>
+struct SettingTopic<SETTING_SENSOR_THRESHOLD>
+    : util::Subscribers<int8_t, &CoverSensor::set_threshold, &SettingsStore::Changed<int8_t>> {};
+
+// \sa SRCState, GlobalState
+struct MuteTopic : util::Subscribers<bool, &ApplyMute> {};
+struct AttenuationTopic : util::Subscribers<uint8_t, &SettingsStore::Changed<uint8_t>> {};
+struct BrightnessTopic
+    : util::Subscribers<uint8_t, &ApplyBrightness, &SettingsStore::Changed<uint8_t>> {};
+
+}  // namespace cdp
+
+#endif  // TOPICS_H_
@@ -65,6 +65,7 @@ public:
 
   static inline bool available() { return !EventQueue::empty(); }
   static inline Event PopEvent() { return EventQueue::Pop(); }
+  static inline util::RingBufferUsage event_queue_usage() { return EventQueue::usage(); }
 
   // NOTE LEDs are active low, default off=high
   static inline void set_led(LED_ID pin, bool on)
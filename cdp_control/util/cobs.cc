@@ -0,0 +1,63 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "cobs.h"
+
+namespace util {
+
+/*static*/ uint8_t Cobs::Encode(const uint8_t *src, uint8_t length, uint8_t *dst)
+{
+  uint8_t *code = dst++;
+  uint8_t *const start = code;
+  uint8_t run = 1;
+  while (length--) {
+    auto c = *src++;
+    if (c) {
+      *dst++ = c;
+      ++run;
+    } else {
+      *code = run;
+      code = dst++;
+      run = 1;
+    }
+  }
+  *code = run;
+  return dst - start;
+}
+
+/*static*/ uint8_t Cobs::Decode(uint8_t *buffer, uint8_t length)
+{
+  const uint8_t *src = buffer;
+  const uint8_t *const end = buffer + length;
+  uint8_t *dst = buffer;
+
+  while (src < end) {
+    const uint8_t code = *src++;
+    if (!code || code - 1 > end - src) return 0;
+    for (uint8_t run = code; --run;) *dst++ = *src++;
+    // A full block (0xff) is not followed by an implied zero
+    if (src < end && code != 0xff) *dst++ = 0;
+  }
+  return dst - buffer;
+}
+
+}  // namespace util
@@ -0,0 +1,70 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef UTIL_COBS_H_
+#define UTIL_COBS_H_
+
+#include <stdint.h>
+
+#include "avrx/progmem.h"
+
+namespace util {
+
+// Consistent Overhead Byte Stuffing, i.e. a framing that removes all 0x00 from the payload so the
+// zero byte can be used as an unambiguous frame delimiter. For our frame sizes (< 254 bytes) the
+// overhead is exactly one byte.
+//
+// Plus a CRC-8 (polynomial 0x07, init 0, same as _crc8_ccitt_update from avr-libc) which is
+// portable and cheap enough to do per byte.
+struct Cobs {
+  static constexpr uint8_t kMaxLength = 253;
+
+  static constexpr uint8_t EncodedLength(uint8_t length) { return length + 1; }
+
+  // Encode `length` bytes from `src` into `dst`, which must hold EncodedLength(length) bytes.
+  // Returns the number of bytes written. The trailing delimiter is *not* added.
+  static uint8_t Encode(const uint8_t *src, uint8_t length, uint8_t *dst);
+
+  // Decode in place (without delimiter). Returns the decoded length, or 0 if the input is invalid.
+  static uint8_t Decode(uint8_t *buffer, uint8_t length);
+};
+
+// Nibble-wise with a 16 entry table, which is a reasonable compromise between flash and cycles.
+inline uint8_t Crc8(uint8_t crc, uint8_t data)
+{
+  static const uint8_t kTable[16] PROGMEM = {0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15,
+                                             0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d};
+  crc ^= data;
+  crc = (crc << 4) ^ pgm_read_byte(&kTable[crc >> 4]);
+  crc = (crc << 4) ^ pgm_read_byte(&kTable[crc >> 4]);
+  return crc;
+}
+
+inline uint8_t Crc8(const uint8_t *data, uint8_t length)
+{
+  uint8_t crc = 0;
+  while (length--) crc = Crc8(crc, *data++);
+  return crc;
+}
+
+}  // namespace util
+
+#endif  // UTIL_COBS_H_
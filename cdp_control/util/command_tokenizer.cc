@@ -58,7 +58,8 @@ CommandTokenizer::Tokens CommandTokenizer::Tokenize(char *line)
         eol = true;
       } else if (isspace(c)) {
         // Spaces end token (\n will probably have been chopped at input)
-        *pos = 0;
+        *pos++ = 0;
+        break;
       } else {
         ++pos;
       }
@@ -67,7 +68,6 @@ CommandTokenizer::Tokens CommandTokenizer::Tokenize(char *line)
       tokens_[num_tokens++] = token;
     else
       eol = true;
-    ++pos;
 
   } while (*pos && !eol);
 
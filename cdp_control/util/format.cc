@@ -0,0 +1,60 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "format.h"
+
+namespace util {
+namespace format {
+
+// Most significant digit first, and the powers are in PROGMEM so they don't take up RAM.
+template <typename U, uint8_t N>
+static inline uint8_t ToDecimal(U value, char *digits, const U (&powers)[N])
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < N; ++i) {
+    const U power = avrx::pgm_read(&powers[i]);
+    char c = '0';
+    while (value >= power) {
+      value -= power;
+      ++c;
+    }
+    if (n || c != '0') digits[n++] = c;
+  }
+  digits[n++] = '0' + value;
+  return n;
+}
+
+uint8_t ToDecimal(uint16_t value, char *digits)
+{
+  static const uint16_t kPowers[] PROGMEM = {10000, 1000, 100, 10};
+  return ToDecimal(value, digits, kPowers);
+}
+
+uint8_t ToDecimal(uint32_t value, char *digits)
+{
+  static const uint32_t kPowers[] PROGMEM = {1000000000, 100000000, 10000000, 1000000, 100000,
+                                             10000,      1000,      100,      10};
+  return ToDecimal(value, digits, kPowers);
+}
+
+}  // namespace format
+}  // namespace util
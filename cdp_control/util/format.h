@@ -0,0 +1,287 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef UTIL_FORMAT_H_
+#define UTIL_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avrx/progmem.h"
+
+// A printf replacement where the format string is parsed at compile time. Each call is expanded
+// into a sequence of (inlined) literal and argument writes, so there's no format interpreter, no
+// varargs and no intermediate buffer; output is streamed straight into a sink.
+//
+//   util::Format(sink, FMT_P("%3u %3u:%02u"), title, minutes, seconds);
+//
+// Supported: %d %i %u %x %X %c %s %S %%, flags '-' and '0', width and precision (strings only).
+// Integer arguments are 16-bit unless they are 32-bit types; 'l' is accepted but ignored. The
+// format string also lives in PROGMEM so literals can be written directly from flash.
+//
+// A sink just needs
+//   void Put(char c);
+//   void PutP(const char *pstr, uint8_t length);  // Exactly `length` chars from PROGMEM
+//
+// NOTE The number/type of arguments are checked at compile time, but %s vs. %S can't be. Also
+// unlike printf, the precision of %s/%S doesn't require the string to be terminated.
+
+#define FMT_P(s)                                                     \
+  ([] {                                                              \
+    struct Fmt {                                                     \
+      static constexpr const char *str() { return s; }               \
+      static const char *pstr() { return PSTR(s); }                  \
+    };                                                               \
+    return Fmt{};                                                    \
+  }())
+
+namespace util {
+
+namespace format {
+
+enum Flags : uint8_t {
+  FLAG_LEFT = 0x1,
+  FLAG_ZERO = 0x2,
+};
+
+struct Spec {
+  uint8_t begin;  // Literal text [begin, end)
+  uint8_t end;
+  uint8_t next;  // Position after spec
+  char conv;     // 0 for end of string
+  uint8_t flags;
+  uint8_t width;
+  uint8_t precision;
+};
+
+constexpr bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+constexpr Spec Parse(const char *fmt, uint8_t pos)
+{
+  Spec spec{pos, pos, pos, 0, 0, 0, 0xff};
+  while (fmt[pos] && fmt[pos] != '%') ++pos;
+  spec.end = pos;
+  if (!fmt[pos]) {
+    spec.next = pos;
+    return spec;
+  }
+  ++pos;
+  for (;; ++pos) {
+    if ('-' == fmt[pos])
+      spec.flags |= FLAG_LEFT;
+    else if ('0' == fmt[pos])
+      spec.flags |= FLAG_ZERO;
+    else
+      break;
+  }
+  while (is_digit(fmt[pos])) spec.width = spec.width * 10 + (fmt[pos++] - '0');
+  if ('.' == fmt[pos]) {
+    spec.precision = 0;
+    ++pos;
+    while (is_digit(fmt[pos])) spec.precision = spec.precision * 10 + (fmt[pos++] - '0');
+  }
+  if ('l' == fmt[pos]) ++pos;  // The argument type determines the size
+  spec.conv = fmt[pos];
+  spec.next = pos + 1;
+  return spec;
+}
+
+// Integer arguments are promoted to 16 bits (like varargs on AVR), or 32 bits.
+template <size_t size> struct Integer {
+  using unsigned_type = uint16_t;
+  using signed_type = int16_t;
+};
+
+template <> struct Integer<4> {
+  using unsigned_type = uint32_t;
+  using signed_type = int32_t;
+};
+
+template <typename Sink> inline void Pad(Sink &sink, char c, uint8_t n)
+{
+  while (n--) sink.Put(c);
+}
+
+// Digits are generated into a small buffer since the width has to be known up front. Using
+// subtraction instead of division is significantly faster on AVR (no hardware divide).
+uint8_t ToDecimal(uint16_t value, char *digits);
+uint8_t ToDecimal(uint32_t value, char *digits);
+
+template <typename U> inline uint8_t ToHex(U value, char *digits, char a)
+{
+  uint8_t n = 0;
+  for (int8_t shift = sizeof(U) * 8 - 4; shift >= 0; shift -= 4) {
+    uint8_t nibble = (value >> shift) & 0xf;
+    if (n || nibble || !shift) digits[n++] = nibble < 10 ? '0' + nibble : a + nibble - 10;
+  }
+  return n;
+}
+
+template <char conv, uint8_t flags, uint8_t width, typename Sink, typename U>
+inline void WriteNumber(Sink &sink, U value, bool negative)
+{
+  char digits[10];
+  uint8_t n;
+  if constexpr ('x' == conv)
+    n = ToHex(value, digits, 'a');
+  else if constexpr ('X' == conv)
+    n = ToHex(value, digits, 'A');
+  else
+    n = ToDecimal(value, digits);
+
+  uint8_t len = n + negative;
+  uint8_t pad = width > len ? width - len : 0;
+  if constexpr (!(flags & (FLAG_LEFT | FLAG_ZERO))) Pad(sink, ' ', pad);
+  if (negative) sink.Put('-');
+  if constexpr (!(flags & FLAG_LEFT) && (flags & FLAG_ZERO)) Pad(sink, '0', pad);
+  for (uint8_t i = 0; i < n; ++i) sink.Put(digits[i]);
+  if constexpr (flags & FLAG_LEFT) Pad(sink, ' ', pad);
+}
+
+template <uint8_t flags, uint8_t width, typename Sink>
+inline void WriteChars(Sink &sink, uint8_t len, const char *str, bool progmem)
+{
+  uint8_t pad = width > len ? width - len : 0;
+  if constexpr (!(flags & FLAG_LEFT)) Pad(sink, ' ', pad);
+  if (progmem) {
+    sink.PutP(str, len);
+  } else {
+    while (len--) sink.Put(*str++);
+  }
+  if constexpr (flags & FLAG_LEFT) Pad(sink, ' ', pad);
+}
+
+template <char conv, uint8_t flags, uint8_t width, uint8_t precision, typename Sink, typename T>
+inline void WriteArg(Sink &sink, T value)
+{
+  if constexpr ('s' == conv || 'S' == conv) {
+    const char *str = value;
+    uint8_t len = 0;
+    if constexpr ('S' == conv)
+      while (len < precision && pgm_read_byte(str + len)) ++len;
+    else
+      while (len < precision && str[len]) ++len;
+    WriteChars<flags, width>(sink, len, str, 'S' == conv);
+  } else if constexpr ('c' == conv) {
+    uint8_t pad = width > 1 ? width - 1 : 0;
+    if constexpr (!(flags & FLAG_LEFT)) Pad(sink, ' ', pad);
+    sink.Put(static_cast<char>(value));
+    if constexpr (flags & FLAG_LEFT) Pad(sink, ' ', pad);
+  } else {
+    static_assert('d' == conv || 'i' == conv || 'u' == conv || 'x' == conv || 'X' == conv,
+                  "Unsupported format conversion");
+    static_assert(sizeof(T) <= 4, "Unsupported argument type");
+    using U = typename Integer<sizeof(T)>::unsigned_type;
+    if constexpr ('d' == conv || 'i' == conv) {
+      typename Integer<sizeof(T)>::signed_type s = value;
+      U u = s;
+      if (s < 0) u = 0 - u;
+      WriteNumber<conv, flags, width>(sink, u, s < 0);
+    } else {
+      WriteNumber<conv, flags, width>(sink, static_cast<U>(value), false);
+    }
+  }
+}
+
+template <typename Fmt, uint8_t begin, uint8_t end, typename Sink>
+inline void WriteLiteral(Sink &sink)
+{
+  if constexpr (end - begin == 1)
+    sink.Put(Fmt::str()[begin]);
+  else if constexpr (end > begin)
+    sink.PutP(Fmt::pstr() + begin, end - begin);
+}
+
+template <typename Fmt, uint8_t pos, typename Sink> inline void Format(Sink &sink)
+{
+  constexpr auto spec = Parse(Fmt::str(), pos);
+  WriteLiteral<Fmt, spec.begin, spec.end>(sink);
+  if constexpr ('%' == spec.conv) {
+    sink.Put('%');
+    Format<Fmt, spec.next>(sink);
+  } else {
+    static_assert(!spec.conv, "Not enough arguments for format");
+  }
+}
+
+template <typename Fmt, uint8_t pos, typename Sink, typename T, typename... Ts>
+inline void Format(Sink &sink, T value, Ts... values)
+{
+  constexpr auto spec = Parse(Fmt::str(), pos);
+  WriteLiteral<Fmt, spec.begin, spec.end>(sink);
+  if constexpr ('%' == spec.conv) {
+    sink.Put('%');
+    Format<Fmt, spec.next>(sink, value, values...);
+  } else {
+    static_assert(spec.conv, "Too many arguments for format");
+    WriteArg<spec.conv, spec.flags, spec.width, spec.precision>(sink, value);
+    Format<Fmt, spec.next>(sink, values...);
+  }
+}
+
+}  // namespace format
+
+// void, but only for FMT_P types, so Print(const char *) style overloads still work for char *
+template <typename Fmt> using if_format_t = decltype(Fmt::pstr(), void());
+
+template <typename Sink, typename Fmt, typename... Args>
+inline void Format(Sink &sink, Fmt, Args... args)
+{
+  format::Format<Fmt, 0>(sink, args...);
+}
+
+// Format into a buffer (always terminated), e.g. for text that's displayed later.
+struct BufferSink {
+  char *pos;
+  char *const end;  // Last usable char, reserved for terminator
+
+  inline void Put(char c)
+  {
+    if (pos < end) *pos++ = c;
+  }
+  inline void PutP(const char *pstr, uint8_t length)
+  {
+    while (length--) Put(pgm_read_byte(pstr++));
+  }
+};
+
+// Returns a pointer to the terminator, i.e. like buffer + sprintf(buffer, ...)
+template <typename Fmt, typename... Args>
+inline char *FormatTo(char *buffer, const char *end, Fmt fmt, Args... args)
+{
+  BufferSink sink{buffer, const_cast<char *>(end) - 1};
+  Format(sink, fmt, args...);
+  *sink.pos = 0;
+  return sink.pos;
+}
+
+template <size_t N, typename Fmt, typename... Args>
+inline char *FormatTo(char (&buffer)[N], Fmt fmt, Args... args)
+{
+  return FormatTo(&buffer[0], buffer + N, fmt, args...);
+}
+
+}  // namespace util
+
+#endif  // UTIL_FORMAT_H_
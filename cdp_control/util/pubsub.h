@@ -0,0 +1,51 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef UTIL_PUBSUB_H_
+#define UTIL_PUBSUB_H_
+
+namespace util {
+
+// Publish/subscribe that is wired at compile time: a topic is a type that lists its subscribers,
+// and publishing is a direct call to each of them. There's no registration, nothing in RAM, and a
+// topic without subscribers compiles to nothing.
+//
+//   struct MuteTopic : util::Subscribers<bool, &ApplyMute, &ShowMute> {};
+//   MuteTopic::Notify(true);  // => ApplyMute(true); ShowMute(true);
+//
+// The topic has to be complete wherever it is published, so the wiring lives in a header next to
+// the topics (\sa topics.h) rather than with the subscribers.
+// NOTE Subscribers run in the publisher's context, so they should be quick (and not publish back).
+template <typename T, void (*... handlers)(T)>
+struct Subscribers {
+  using value_type = T;
+
+  static inline void Notify(T value) { (handlers(value), ...); }
+};
+
+// Default topic for things nobody listens to
+struct NoSubscribers {
+  template <typename T> static inline void Notify(T) {}
+};
+
+}  // namespace util
+
+#endif  // UTIL_PUBSUB_H_
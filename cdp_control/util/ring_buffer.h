@@ -26,6 +26,12 @@
 
 namespace util {
 
+// Fill level statistics, e.g. for the `mem` command
+struct RingBufferUsage {
+  uint8_t high_water;
+  uint8_t size;
+};
+
 // Single producer, single consumer
 // TODO For use in the same context, we might typedef the index type to volatile/non-volatile
 
@@ -43,18 +49,25 @@ public:
   {
     uint8_t w = write_pos_;
     values_[w & kMask] = t;
-    write_pos_ = w + 1;
+    write_pos_ = ++w;
+    UpdateHighWater(w);
   }
 
   template <typename... Args> static inline void Emplace(Args&&... args)
   {
     uint8_t w = write_pos_;
     values_[w & kMask] = T{args...};
-    write_pos_ = w + 1;
+    write_pos_ = ++w;
+    UpdateHighWater(w);
   }
 
   static inline T& Head() { return values_[write_pos_ & kMask]; }
-  static inline void Push() { write_pos_ = write_pos_ + 1; }
+  static inline void Push()
+  {
+    uint8_t w = write_pos_ + 1;
+    write_pos_ = w;
+    UpdateHighWater(w);
+  }
 
   static inline T Pop()
   {
@@ -64,16 +77,30 @@ public:
     return t;
   }
 
+  // Access the oldest element in place, e.g. to consume it in several steps.
+  static inline T& Tail() { return values_[read_pos_ & kMask]; }
+  static inline void Skip() { read_pos_ = read_pos_ + 1; }
+
   static inline uint8_t empty() { return write_pos_ == read_pos_; }
   static inline uint8_t readable() { return write_pos_ - read_pos_; }
+  static inline uint8_t writable() { return kSize - readable(); }
 
   // Danger
   static inline void Clear() { write_pos_ = read_pos_ = 0; }
 
+  static inline RingBufferUsage usage() { return {high_water_, kSize}; }
+
 private:
   static value_type values_[kSize];
   static volatile uint8_t write_pos_;
   static volatile uint8_t read_pos_;
+  static uint8_t high_water_;  // Only updated by the producer
+
+  static inline void UpdateHighWater(uint8_t w)
+  {
+    uint8_t n = w - read_pos_;
+    if (n > high_water_) high_water_ = n;
+  }
 };
 
 template <typename Owner, typename T, uint8_t N> T RingBuffer<Owner, T, N>::values_[];
@@ -81,6 +108,7 @@ template <typename Owner, typename T, uint8_t N>
 volatile uint8_t RingBuffer<Owner, T, N>::write_pos_ = 0;
 template <typename Owner, typename T, uint8_t N>
 volatile uint8_t RingBuffer<Owner, T, N>::read_pos_ = 0;
+template <typename Owner, typename T, uint8_t N> uint8_t RingBuffer<Owner, T, N>::high_water_ = 0;
 
 }  // namespace util
 
@@ -0,0 +1,79 @@
+// cdpfw
+// Copyright (C) 2023 Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+#ifndef UTIL_SCRATCH_ARENA_H_
+#define UTIL_SCRATCH_ARENA_H_
+
+#include <stdint.h>
+
+namespace util {
+
+// Stack-like allocator for short-lived buffers (frames, formatted text) so they can share the same
+// bit of RAM instead of each having its own static array. Allocations belong to a Frame and are
+// released when it goes out of scope, so nested frames must be strictly LIFO, which is the case
+// for anything called from the main loop.
+//
+//   Scratch::Frame frame;
+//   auto buffer = frame.Alloc<char>(40);
+//   if (!buffer) return;
+//
+// The arena has to be sized for the deepest nesting; an allocation that doesn't fit returns
+// nullptr. high_water() is the most ever in use, and exceeds kSize if an allocation failed.
+// NOTE Not for use in ISRs.
+template <typename Owner, uint8_t N> class ScratchArena {
+public:
+  static constexpr uint8_t kSize = N;
+
+  class Frame {
+  public:
+    Frame() : saved_top_(top_) {}
+    ~Frame() { top_ = saved_top_; }
+
+    template <typename T> T *Alloc(uint8_t count)
+    {
+      static_assert(alignof(T) == 1, "Byte buffers only");  // No padding for alignment
+      uint16_t top = top_ + count * sizeof(T);
+      if (top > high_water_) high_water_ = top > 0xff ? 0xff : top;
+      if (top > kSize) return nullptr;
+      auto ptr = reinterpret_cast<T *>(buffer_ + top_);
+      top_ = top;
+      return ptr;
+    }
+
+  private:
+    const uint8_t saved_top_;
+  };
+
+  static inline uint8_t high_water() { return high_water_; }
+
+private:
+  static uint8_t buffer_[kSize];
+  static uint8_t top_;
+  static uint8_t high_water_;
+};
+
+template <typename Owner, uint8_t N> uint8_t ScratchArena<Owner, N>::buffer_[];
+template <typename Owner, uint8_t N> uint8_t ScratchArena<Owner, N>::top_ = 0;
+template <typename Owner, uint8_t N> uint8_t ScratchArena<Owner, N>::high_water_ = 0;
+
+}  // namespace util
+
+#endif  // UTIL_SCRATCH_ARENA_H_
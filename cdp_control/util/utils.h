@@ -22,6 +22,10 @@
 #ifndef UTIL_H_
 #define UTIL_H_
 
+#include <stdint.h>
+
+#include "pubsub.h"
+
 #define MACRO_STRING(x) #x
 #define MACRO_PASTE_(x, y) x##y
 #define MACRO_PASTE(x, y) MACRO_PASTE_(x, y)
@@ -46,11 +50,13 @@ constexpr T clamp(T value, T min, T max)
 
 // Track a variable to know when it has been changed.
 // Recommended for basic (integer) types but this isn't enforced.
+// Changes are also published to the Topic's subscribers (\sa pubsub.h).
 //
 // TODO clamp?
-template <typename T>
+template <typename T, typename Topic = NoSubscribers>
 struct Variable {
   using value_type = T;
+  static constexpr uint8_t kDirtyBit = 1;
 
   constexpr explicit Variable(T value) : value_{value} {}
 
@@ -59,7 +65,8 @@ struct Variable {
   {
     if (value_ != value) {
       value_ = value;
-      dirty_ = true;
+      dirty_ = kDirtyBit;
+      Topic::Notify(value);
     }
   }
 
@@ -68,28 +75,82 @@ struct Variable {
   void operator=(T value) { set(value); }
 
   inline bool dirty() const { return dirty_; }
-  inline void force_dirty() { dirty_ = true; }
-  inline void clear() { dirty_ = false; }
+  inline void force_dirty() { dirty_ = kDirtyBit; }
+  inline void clear() { dirty_ = 0; }
+
+  // Notify subscribers of the current value, e.g. at init
+  inline void publish() const { Topic::Notify(value_); }
+
+  // For type-erased access, \sa console::Value
+  // NOTE value_ is the first member so this is also a pointer to the Variable.
+  constexpr T *value_ptr() { return &value_; }
 
 private:
   T value_;
-  bool dirty_ = false;
+  uint8_t dirty_ = 0;
 
   Variable() = delete;
   DISALLOW_COPY_AND_ASSIGN(Variable);
 };
 
-template <typename... Ts>
-void ClearDirtyVariables(Variable<Ts> &...vars)
-{
-  (vars.clear(), ...);
-}
+// The members of a state struct can share a dirty mask instead of each having its own flag, so
+// "did anything (relevant) change?" is a single test and clearing is a single store. Since there's
+// only one instance of the state structs the mask is static, per Owner.
+//
+//   struct State {
+//     using Dirty = util::DirtyMask<State>;
+//     enum : uint8_t { DIRTY_A = 0x1, DIRTY_B = 0x2 };
+//     util::GroupVariable<Dirty, bool, DIRTY_A> a{false};
+//     util::GroupVariable<Dirty, uint8_t, DIRTY_B> b{0};
+//   };
+//   if (State::Dirty::test(State::DIRTY_A | State::DIRTY_B)) ...
+template <typename Owner>
+struct DirtyMask {
+  static inline bool test(uint8_t bits) { return mask_ & bits; }
+  static inline void set(uint8_t bits) { mask_ |= bits; }
+  static inline void clear(uint8_t bits) { mask_ &= ~bits; }
+  static inline uint8_t mask() { return mask_; }
 
-template <typename ...Ts>
-void ForceDirtyVariables(Variable<Ts> &...vars)
-{
-  (vars.force_dirty(), ...);
-}
+  static uint8_t mask_;
+};
+
+template <typename Owner> uint8_t DirtyMask<Owner>::mask_ = 0;
+
+// Same interface as Variable, except the dirty flag is a bit in the group's mask.
+template <typename Group, typename T, uint8_t bit, typename Topic = NoSubscribers>
+struct GroupVariable {
+  using value_type = T;
+  static constexpr uint8_t kDirtyBit = bit;
+
+  constexpr explicit GroupVariable(T value) : value_{value} {}
+
+  inline T get() const { return value_; }
+  inline void set(T value)
+  {
+    if (value_ != value) {
+      value_ = value;
+      Group::set(kDirtyBit);
+      Topic::Notify(value);
+    }
+  }
+
+  operator T() const { return value_; }
+  void operator=(T value) { set(value); }
+
+  inline bool dirty() const { return Group::test(kDirtyBit); }
+  inline void force_dirty() { Group::set(kDirtyBit); }
+  inline void clear() { Group::clear(kDirtyBit); }
+
+  inline void publish() const { Topic::Notify(value_); }
+
+  constexpr T *value_ptr() { return &value_; }
+
+private:
+  T value_;
+
+  GroupVariable() = delete;
+  DISALLOW_COPY_AND_ASSIGN(GroupVariable);
+};
 
 }  // namespace util
 